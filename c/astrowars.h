@@ -4,8 +4,8 @@
 extern vfd_game game_astrowars;
 
 void astrowars_prepare_display(ucom4cpu *cpu);
-void astrowars_setup_gfx(void);
-void astrowars_display_update(void);
+void astrowars_setup_gfx(struct _vfd_render *r);
+void astrowars_display_update(struct _vfd_render *r);
 void astrowars_output_w(ucom4cpu *cpu, int index, uint8_t data);
 uint8_t astrowars_input_r(ucom4cpu *cpu, int index);
-void astrowars_close_gfx(void);
\ No newline at end of file
+void astrowars_close_gfx(struct _vfd_render *r);
\ No newline at end of file
@@ -0,0 +1,94 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * astrowars_gfx.c
+ *
+ * Drawing half of the astrowars driver: bezel, background and the
+ * segments scaled into the bezel window.
+ *
+ *************************/
+#include <SDL.h>
+#include <SDL_image.h>
+#include "driver.h"
+#include "astrowars.h"
+#include "render.h"
+
+#include "lib/SDL_rotozoom.h"
+
+vfd_gfx gfx_astrowars = {
+	.game = &game_astrowars,
+	.setup_gfx = astrowars_setup_gfx,
+	.close_gfx = astrowars_close_gfx,
+	.display_update = astrowars_display_update
+};
+
+void astrowars_close_gfx(vfd_render *r) {
+	segload_close(&r->segs);
+	layout_close(&r->layout);
+	SDL_FreeSurface(r->bg);
+	SDL_FreeSurface(r->bezel);
+	SDL_FreeSurface(r->vfd);
+}
+
+#define BEZEL 1
+
+void astrowars_setup_gfx(vfd_render *r) {
+	IMG_Init(IMG_INIT_PNG);
+
+	r->bg=IMG_Load("res/gfx/astrowars/bg3.png");
+
+	r->bezel=IMG_Load("res/gfx/astrowars/bezel.png");
+
+	// segments are drawn here, then scaled into the bezel window
+	r->vfd=IMG_Load("res/gfx/astrowars/bg3.png");
+
+	if(!r->bg || !r->bezel || !r->vfd)
+		return;
+
+	// segment positions come from the compiled layout, the images are
+	// decoded in the background as they first light up
+	if(layout_open(&r->layout, r->game->layout) < 0)
+		return;
+	segload_open(&r->segs, "res/gfx/astrowars/", &r->layout);
+
+	if(BEZEL) {
+		r->w = r->bezel->w;
+		r->h = r->bezel->h;
+	} else {
+		r->w = r->bg->w;
+		r->h = r->bg->h;
+	}
+}
+
+void astrowars_display_update(vfd_render *r) {
+	SDL_Rect rect;
+	SDL_Surface *tmp;
+
+	SDL_FillRect(r->out, NULL, SDL_MapRGB(r->out->format, 0,0,0));
+
+	SDL_FillRect(r->vfd, NULL, SDL_MapRGB(r->vfd->format, 0,0,0));
+
+	segload_draw(&r->segs, r->cpu->display_cache, r->vfd);
+
+	if(BEZEL) {
+		rect.x=192;
+		rect.y=84;
+		rect.w=274-182;
+		rect.h=362-84;
+
+		tmp = rotozoomSurface(r->vfd, 0, .35,1);//rect.w/vfd_display->w,1);
+
+		SDL_BlitSurface(tmp, NULL, r->out, &rect);
+
+		SDL_FreeSurface(tmp);
+
+		SDL_BlitSurface(r->bezel, NULL, r->out, NULL);
+	} else {
+		SDL_BlitSurface(r->vfd,NULL,r->out,NULL);
+	}
+}
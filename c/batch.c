@@ -0,0 +1,277 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * batch.c
+ *
+ *************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+
+#include "batch.h"
+
+// owner end of a queue
+
+static int queue_pop(batch_queue *q, int *m)
+{
+	int found = 0;
+
+	pthread_mutex_lock(&q->lock);
+	if(q->tail > q->head) {
+		*m = q->items[--q->tail];
+		found = 1;
+	}
+	pthread_mutex_unlock(&q->lock);
+
+	return found;
+}
+
+static void queue_push(batch_queue *q, int m)
+{
+	pthread_mutex_lock(&q->lock);
+	if(q->tail == q->head)
+		q->head = q->tail = 0;
+	q->items[q->tail++] = m;
+	pthread_mutex_unlock(&q->lock);
+}
+
+// thief end, takes the machine the owner will get to last
+
+static int queue_steal(batch_queue *q, int *m)
+{
+	int found = 0;
+
+	pthread_mutex_lock(&q->lock);
+	if(q->tail > q->head) {
+		*m = q->items[q->head++];
+		found = 1;
+	}
+	pthread_mutex_unlock(&q->lock);
+
+	return found;
+}
+
+// one slice of one machine, cut short at the next replay event
+
+static void batch_step(batch *b, batch_machine *m)
+{
+	int32_t ticks = m->budget < b->slice ? m->budget : b->slice;
+	int32_t until;
+
+	if(m->input)
+		m->input(m, m->user);
+
+	while(m->next_event < m->event_count && m->events[m->next_event].cycle <= (uint32_t)m->cpu.totalticks) {
+		replay_apply(m->inputs, m->events[m->next_event].val);
+		m->next_event++;
+	}
+
+	if(m->next_event < m->event_count) {
+		until = (int32_t)(m->events[m->next_event].cycle - m->cpu.totalticks);
+		if(until > 0 && until < ticks)
+			ticks = until;
+	}
+
+	ucom4_exec(&m->cpu, ticks);
+	m->budget -= ticks;
+}
+
+static void batch_work(batch *b, int self)
+{
+	int m, x;
+
+	while(atomic_load_explicit(&b->remaining, memory_order_acquire) > 0) {
+		if(!queue_pop(&b->queues[self], &m)) {
+			for(x = 1; x < b->threads; x++)
+				if(queue_steal(&b->queues[(self + x) % b->threads], &m))
+					break;
+
+			if(x >= b->threads) {
+				sched_yield();
+				continue;
+			}
+			atomic_fetch_add_explicit(&b->steals, 1, memory_order_relaxed);
+		}
+
+		batch_step(b, &b->machines[m]);
+
+		if(b->machines[m].budget > 0)
+			queue_push(&b->queues[self], m);
+		else
+			atomic_fetch_sub_explicit(&b->remaining, 1, memory_order_release);
+	}
+}
+
+static void *batch_worker(void *data)
+{
+	batch_queue *q = data;
+	batch *b = q->batch;
+	int self = q - b->queues;
+	int seen = 0;
+
+	pthread_mutex_lock(&b->lock);
+	for(;;) {
+		while(b->generation == seen && !b->quit)
+			pthread_cond_wait(&b->start, &b->lock);
+		if(b->quit)
+			break;
+		seen = b->generation;
+		pthread_mutex_unlock(&b->lock);
+
+		batch_work(b, self);
+
+		pthread_mutex_lock(&b->lock);
+		if(--b->active == 0)
+			pthread_cond_signal(&b->done);
+	}
+	pthread_mutex_unlock(&b->lock);
+
+	return NULL;
+}
+
+batch *batch_create(vfd_game *game, int count, int threads)
+{
+	batch *b;
+	int x;
+
+	if(count < 1 || threads < 1)
+		return NULL;
+
+	b = calloc(1, sizeof(batch));
+	if(!b)
+		return NULL;
+
+	b->game = game;
+	b->count = count;
+	b->threads = threads;
+	b->slice = BATCH_SLICE;
+	b->machines = calloc(count, sizeof(batch_machine));
+	b->workers = calloc(threads, sizeof(pthread_t));
+	b->queues = calloc(threads, sizeof(batch_queue));
+
+	if(!b->machines || !b->workers || !b->queues)
+		goto fail;
+
+	// every machine shares the rom and gets its own driver state
+	for(x = 0; x < count; x++) {
+		batch_machine *m = &b->machines[x];
+
+		m->id = x;
+		if(load_rom(&m->cpu, game) != game->romsize) {
+			printf("Failed to load rom [%s]\n", game->rom);
+			goto fail;
+		}
+		if(game->state_size && !(m->state = calloc(1, game->state_size)))
+			goto fail;
+		machine_attach(&m->cpu, game, m->inputs, m->state);
+	}
+
+	batch_reset(b);
+
+	pthread_mutex_init(&b->lock, NULL);
+	pthread_cond_init(&b->start, NULL);
+	pthread_cond_init(&b->done, NULL);
+	atomic_init(&b->remaining, 0);
+	atomic_init(&b->steals, 0);
+
+	for(x = 0; x < threads; x++) {
+		b->queues[x].batch = b;
+		b->queues[x].items = malloc(count * sizeof(int));
+		pthread_mutex_init(&b->queues[x].lock, NULL);
+		if(!b->queues[x].items)
+			goto fail;
+	}
+
+	for(x = 0; x < threads; x++) {
+		if(pthread_create(&b->workers[x], NULL, batch_worker, &b->queues[x]))
+			goto fail;
+		b->started++;
+	}
+
+	return b;
+
+fail:
+	batch_destroy(b);
+	return NULL;
+}
+
+void batch_destroy(batch *b)
+{
+	int x;
+
+	if(!b)
+		return;
+
+	if(b->started) {
+		pthread_mutex_lock(&b->lock);
+		b->quit = 1;
+		pthread_cond_broadcast(&b->start);
+		pthread_mutex_unlock(&b->lock);
+
+		for(x = 0; x < b->started; x++)
+			pthread_join(b->workers[x], NULL);
+	}
+
+	if(b->queues)
+		for(x = 0; x < b->threads; x++)
+			free(b->queues[x].items);
+
+	if(b->machines)
+		for(x = 0; x < b->count; x++)
+			free(b->machines[x].state);
+
+	free(b->queues);
+	free(b->workers);
+	free(b->machines);
+	free(b);
+}
+
+void batch_reset(batch *b)
+{
+	batch_machine *m;
+	int x;
+
+	for(x = 0; x < b->count; x++) {
+		m = &b->machines[x];
+
+		ucom4_reset(&m->cpu);
+		m->cpu.cpu_rate = 100000;
+		m->cpu.sound_frequency = 0;     // no audio, nobody drains it
+		m->next_event = 0;
+		memset(m->inputs, 0, sizeof(m->inputs));
+		if(m->state)
+			memset(m->state, 0, b->game->state_size);
+	}
+}
+
+// run every machine for another cycles ticks, returns when all are done
+
+void batch_run(batch *b, int32_t cycles)
+{
+	int x;
+
+	for(x = 0; x < b->threads; x++)
+		b->queues[x].head = b->queues[x].tail = 0;
+
+	// deal the machines out round robin, the lowest index ends up on top
+	for(x = b->count - 1; x >= 0; x--) {
+		b->machines[x].budget = cycles;
+		b->queues[x % b->threads].items[b->queues[x % b->threads].tail++] = x;
+	}
+
+	atomic_store_explicit(&b->remaining, b->count, memory_order_release);
+
+	pthread_mutex_lock(&b->lock);
+	b->active = b->threads;
+	b->generation++;
+	pthread_cond_broadcast(&b->start);
+	while(b->active)
+		pthread_cond_wait(&b->done, &b->lock);
+	pthread_mutex_unlock(&b->lock);
+}
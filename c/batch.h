@@ -0,0 +1,86 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * batch.h
+ *
+ *************************/
+
+#ifndef _BATCH_H_
+#define _BATCH_H_
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "vfd_emu.h"
+#include "driver.h"
+#include "replay.h"
+
+// BATCH RUNNER
+//
+// Many independent headless machines of one driver, stepped for a cycle
+// budget by a pool of worker threads. Every worker owns a queue of
+// machines, runs the one at its tail for a slice and puts it back;
+// idle workers steal from the head of the other queues.
+
+#define BATCH_SLICE 2000                // cycles per slice, one frame at 50 fps
+
+typedef struct _batch_machine batch_machine;
+
+// called before every slice, may change m->inputs
+typedef void (*batch_input_cb)(batch_machine *m, void *user);
+
+struct _batch_machine {
+	ucom4cpu cpu;
+	uint8_t inputs[INPUTS_NUM];
+	void *state;                        // own copy of the driver state block
+	int id;
+
+	// input source: a callback, a replay stream, or both
+	batch_input_cb input;
+	void *user;
+	struct input_event *events;
+	int event_count;
+	int next_event;
+
+	int32_t budget;                     // cycles left in the current run
+};
+
+typedef struct _batch_queue {
+	struct _batch *batch;
+	pthread_mutex_t lock;
+	int *items;                         // machine indices
+	int head, tail;
+} batch_queue;
+
+typedef struct _batch {
+	vfd_game *game;
+	batch_machine *machines;
+	int count;
+	int32_t slice;
+
+	int threads;
+	int started;                        // worker threads running
+	pthread_t *workers;
+	batch_queue *queues;
+
+	pthread_mutex_t lock;
+	pthread_cond_t start, done;
+	int generation;
+	int active;
+	int quit;
+	atomic_int remaining;
+	atomic_ullong steals;
+} batch;
+
+batch *batch_create(vfd_game *game, int count, int threads);
+void batch_destroy(batch *b);
+void batch_reset(batch *b);
+void batch_run(batch *b, int32_t cycles);
+
+#endif
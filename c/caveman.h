@@ -4,8 +4,8 @@
 extern vfd_game game_caveman;
 
 void caveman_prepare_display(ucom4cpu *cpu);
-void caveman_setup_gfx(void);
-void caveman_display_update(void);
+void caveman_setup_gfx(struct _vfd_render *r);
+void caveman_display_update(struct _vfd_render *r);
 void caveman_output_w(ucom4cpu *cpu, int index, uint8_t data);
 uint8_t caveman_input_r(ucom4cpu *cpu, int index);
-void caveman_close_gfx(void);
+void caveman_close_gfx(struct _vfd_render *r);
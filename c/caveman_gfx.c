@@ -0,0 +1,61 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * caveman_gfx.c
+ *
+ * Drawing half of the caveman driver.
+ *
+ *************************/
+#include <stdio.h>
+#include <SDL.h>
+#include <SDL_image.h>
+#include "driver.h"
+#include "caveman.h"
+#include "render.h"
+
+vfd_gfx gfx_caveman = {
+	.game = &game_caveman,
+	.setup_gfx = caveman_setup_gfx,
+	.close_gfx = caveman_close_gfx,
+	.display_update = caveman_display_update
+};
+
+void caveman_close_gfx(vfd_render *r) {
+	segload_close(&r->segs);
+	layout_close(&r->layout);
+	SDL_FreeSurface(r->bg);
+}
+
+void caveman_setup_gfx(vfd_render *r) {
+	char filename[255];
+
+	char hd[4]="hd/";
+	
+	IMG_Init(IMG_INIT_PNG);
+
+	sprintf(filename,"res/gfx/caveman/%svfd.png",hd);
+
+	r->bg=IMG_Load(filename);
+
+	// segment positions come from the compiled layout, the images are
+	// decoded in the background as they first light up
+	if(layout_open(&r->layout, r->game->layout) < 0)
+		return;
+	sprintf(filename,"res/gfx/caveman/%s",hd);
+	segload_open(&r->segs, filename, &r->layout);
+
+	r->w = 1000;
+	r->h = 300;
+}
+
+void caveman_display_update(vfd_render *r) {
+//	SDL_BlitSurface(r->bg, NULL, r->out, NULL);
+	SDL_FillRect(r->out, NULL, SDL_MapRGB(r->out->format, 0,0,0));
+
+	segload_draw(&r->segs, r->cpu->display_cache, r->out);
+}
@@ -20,15 +20,18 @@
 
 // GAME DRIVER DEFINITION
 
+struct _vfd_render;
 
 typedef struct _gamedriver {
 
 	void (*prepare_display)(ucom4cpu *cpu);
 	void (*cpu_exec)(int ticks);
 
-	void (*setup_gfx)(void);
-	void (*close_gfx)(void);
-	void (*display_update)(void);
+	// non volatile memory of the frontend's machine, kept in a file (may be NULL)
+	void (*open_store)(ucom4cpu *cpu);
+	void (*close_store)(ucom4cpu *cpu);
+	// the same memory inside cpu's state, replays carry a copy (may be NULL)
+	void *(*nvram)(ucom4cpu *cpu, int *size);
 
 	uint8_t (*input_r)(ucom4cpu *cpu, int index);
 	void (*output_w)(ucom4cpu *cpu, int index, uint8_t data);
@@ -37,11 +40,21 @@ typedef struct _gamedriver {
 
 	char rom[255];
 	int romsize;
-	ucom4cpu *cpu;
+	uint32_t romcrc;                    // expected CRC32 and SHA1 of the rom file, 0 / "" to skip
+	char romsha1[41];
+	char layout[255];                   // compiled segment layout in LAYOUT_DIR
+
+	// size of the driver state block (external chips etc) every machine
+	// allocates for itself, saved verbatim in save states
+	int state_size;
 
 } vfd_game;
 
-extern vfd_game *active_game;
+// every driver, NULL terminated (drivers.c)
+#define VFD_DEFAULT_DRIVER "sonytaax44"
+
+extern vfd_game *vfd_drivers[];
+vfd_game *driver_find(const char *name);
 
 #include "astrowars.h"
 #include "caveman.h"
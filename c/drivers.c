@@ -0,0 +1,36 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * drivers.c
+ *
+ *************************/
+#include <string.h>
+
+#include "driver.h"
+
+// DRIVER REGISTRY
+// every frontend, the benchmark and the library pick drivers from here,
+// a new game only needs its line in this table
+
+vfd_game *vfd_drivers[] = {
+	&game_astrowars,
+	&game_caveman,
+	&game_sonytaax44,
+	NULL
+};
+
+vfd_game *driver_find(const char *name)
+{
+	vfd_game **game;
+
+	for(game = vfd_drivers; *game; game++)
+		if(!strcmp((*game)->name, name))
+			return *game;
+
+	return NULL;
+}
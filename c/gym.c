@@ -0,0 +1,138 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * gym.c
+ *
+ *************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gym.h"
+#include "savestate.h"
+
+gym_env *gym_create(vfd_game *game)
+{
+	gym_env *env;
+
+	env = calloc(1, sizeof(gym_env));
+	if(!env)
+		return NULL;
+
+	env->game = game;
+
+	if(load_rom(&env->cpu, game) != game->romsize) {
+		printf("Failed to load rom [%s]\n", game->rom);
+		goto fail;
+	}
+
+	if(game->state_size && !(env->state = calloc(1, game->state_size)))
+		goto fail;
+
+	machine_attach(&env->cpu, game, env->inputs, env->state);
+
+	env->obs.display = env->cpu.display_cache;
+	gym_reset(env);
+
+	return env;
+
+fail:
+	gym_destroy(env);
+	return NULL;
+}
+
+void gym_destroy(gym_env *env)
+{
+	if(!env)
+		return;
+
+	free(env->state);
+	free(env);
+}
+
+void gym_hooks(gym_env *env, gym_reward_cb reward, gym_done_cb done, void *user)
+{
+	env->reward = reward;
+	env->done = done;
+	env->user = user;
+}
+
+const gym_obs *gym_observe(gym_env *env)
+{
+	env->obs.rows = env->cpu.display_maxy;
+	env->obs.cols = env->cpu.display_maxx;
+
+	return &env->obs;
+}
+
+const gym_obs *gym_reset(gym_env *env)
+{
+	ucom4_reset(&env->cpu);
+	env->cpu.cpu_rate = 100000;
+	env->cpu.sound_frequency = 0;       // no audio, nobody drains it
+
+	memset(env->inputs, 0, sizeof(env->inputs));
+	if(env->state)
+		memset(env->state, 0, env->game->state_size);
+
+	env->obs.reward = 0;
+	env->obs.done = 0;
+	env->obs.frame = 0;
+
+	return gym_observe(env);
+}
+
+// hold the action bits (bit n is input line n) for up to frames frames,
+// stopping early once the done hook says so
+
+const gym_obs *gym_step(gym_env *env, uint32_t action, int frames)
+{
+	int x;
+
+	env->obs.reward = 0;
+
+	for(x = 0; x < INPUTS_NUM; x++)
+		env->inputs[x] = (action >> x) & 1;
+
+	while(frames-- > 0 && !env->obs.done) {
+		ucom4_exec(&env->cpu, GYM_FRAME_CYCLES);
+		env->obs.frame++;
+
+		if(env->reward)
+			env->obs.reward += env->reward(env, env->user);
+		if(env->done)
+			env->obs.done = env->done(env, env->user);
+	}
+
+	return gym_observe(env);
+}
+
+// clone / restore go through save state blobs, the frame count follows
+// the restored cycle count and the done flag is cleared
+
+int gym_state_size(gym_env *env)
+{
+	return savestate_size(&env->cpu);
+}
+
+int gym_clone(gym_env *env, uint8_t *buf, int size)
+{
+	return savestate_save(&env->cpu, buf, size);
+}
+
+int gym_restore(gym_env *env, const uint8_t *buf, int size)
+{
+	int len = savestate_load(&env->cpu, buf, size);
+
+	if(len) {
+		env->obs.done = 0;
+		env->obs.frame = (env->cpu.totalticks + GYM_FRAME_CYCLES / 2) / GYM_FRAME_CYCLES;
+	}
+
+	return len;
+}
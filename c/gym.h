@@ -0,0 +1,69 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * gym.h
+ *
+ *************************/
+
+#ifndef _GYM_H_
+#define _GYM_H_
+
+#include <stdint.h>
+
+#include "machine.h"
+#include "driver.h"
+
+// STEP / OBSERVE API
+//
+// One headless machine for agents: reset it, step it a few frames with a
+// set of input bits held down, look at the display. Nothing here touches
+// SDL; the observation points straight at the cpu's display_cache.
+// Built into libvfdemu, see the Makefile.
+
+#define GYM_FRAME_CYCLES 2000           // one frame at 50 fps
+
+typedef struct _gym_env gym_env;
+
+// called after every frame of a step
+typedef int32_t (*gym_reward_cb)(gym_env *env, void *user);
+typedef int (*gym_done_cb)(gym_env *env, void *user);
+
+typedef struct _gym_obs {
+	const uint32_t *display;            // display_cache rows, bit x of row y is one segment
+	int rows, cols;
+	int32_t reward;                     // summed over the frames of the last step
+	int done;
+	uint32_t frame;
+} gym_obs;
+
+struct _gym_env {
+	vfd_game *game;
+	ucom4cpu cpu;
+	uint8_t inputs[INPUTS_NUM];
+	void *state;
+
+	gym_reward_cb reward;
+	gym_done_cb done;
+	void *user;
+
+	gym_obs obs;
+};
+
+gym_env *gym_create(vfd_game *game);
+void gym_destroy(gym_env *env);
+void gym_hooks(gym_env *env, gym_reward_cb reward, gym_done_cb done, void *user);
+
+const gym_obs *gym_reset(gym_env *env);
+const gym_obs *gym_step(gym_env *env, uint32_t action, int frames);
+const gym_obs *gym_observe(gym_env *env);
+
+int gym_state_size(gym_env *env);
+int gym_clone(gym_env *env, uint8_t *buf, int size);
+int gym_restore(gym_env *env, const uint8_t *buf, int size);
+
+#endif
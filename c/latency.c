@@ -0,0 +1,103 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * latency.c
+ *
+ *************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "latency.h"
+
+#define LATENCY_BAR 40
+
+void latency_input(latency *l, const uint32_t *display, int32_t cycle, uint32_t frame, int64_t now)
+{
+	if(l->pending) {
+		l->overlapped++;
+		return;
+	}
+
+	l->pending = 1;
+	l->cycle = cycle;
+	l->frame = frame;
+	l->host = now;
+	memcpy(l->display, display, sizeof(l->display));
+}
+
+// 1 when this display closed a sample
+
+int latency_display(latency *l, const uint32_t *display, int32_t cycle, uint32_t frame, int64_t now)
+{
+	uint32_t frames;
+	int64_t host;
+	int ms;
+
+	if(!l->pending)
+		return 0;
+
+	frames = frame - l->frame;
+
+	if(!memcmp(l->display, display, sizeof(l->display))) {
+		if(frames >= LATENCY_TIMEOUT) {
+			l->timeouts++;
+			l->pending = 0;
+		}
+		return 0;
+	}
+
+	host = now - l->host;
+	ms = host / 1000000 / LATENCY_MS_STEP;
+
+	l->frames[frames < LATENCY_BUCKETS ? frames : LATENCY_BUCKETS - 1]++;
+	l->ms[ms < LATENCY_BUCKETS ? ms : LATENCY_BUCKETS - 1]++;
+	l->samples++;
+	l->cycles_sum += cycle - l->cycle;
+	l->host_sum += host;
+	if(host > l->host_max)
+		l->host_max = host;
+	l->last = host;
+	l->pending = 0;
+
+	return 1;
+}
+
+static void latency_histogram(FILE *f, const uint32_t *hist, const char *unit, int step)
+{
+	uint32_t top = 1;
+	int x, y;
+
+	for(x=0;x<LATENCY_BUCKETS;x++)
+		if(hist[x] > top)
+			top = hist[x];
+
+	for(x=0;x<LATENCY_BUCKETS;x++) {
+		if(!hist[x])
+			continue;
+		fprintf(f, " %3d%s %-6s %6u  ", x * step, x == LATENCY_BUCKETS - 1 ? "+" : " ", unit, hist[x]);
+		for(y=0;y<(int)(hist[x] * LATENCY_BAR / top);y++)
+			fputc('#', f);
+		fputc('\n', f);
+	}
+}
+
+void latency_report(latency *l, FILE *f, int cpu_rate)
+{
+	fprintf(f, "Latency: %u samples, %u overlapped, %u without display change\n",
+		l->samples, l->overlapped, l->timeouts);
+
+	if(!l->samples)
+		return;
+
+	fprintf(f, "Latency: avg %.2f ms host (max %.2f), %.2f ms emulated\n",
+		l->host_sum / 1e6 / l->samples, l->host_max / 1e6,
+		l->cycles_sum * 1000.0 / cpu_rate / l->samples);
+
+	latency_histogram(f, l->frames, "frames", 1);
+	latency_histogram(f, l->ms, "ms", LATENCY_MS_STEP);
+}
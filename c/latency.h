@@ -0,0 +1,53 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * latency.h
+ *
+ *************************/
+
+#ifndef _LATENCY_H_
+#define _LATENCY_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+// INPUT TO DISPLAY LATENCY
+//
+// latency_input() stamps an input change with its emulated cycle, frame
+// and host time and keeps a copy of the display. latency_display() is
+// called with every drawn display; the first one that differs closes the
+// sample. Changes made while a sample is open are not stamped, and a
+// sample with no display change within LATENCY_TIMEOUT frames is dropped.
+
+#define LATENCY_BUCKETS 16              // the last bucket takes everything above
+#define LATENCY_MS_STEP 5
+#define LATENCY_TIMEOUT 50              // frames
+
+typedef struct _latency {
+	int pending;
+	int32_t cycle;
+	uint32_t frame;
+	int64_t host;                       // ns
+	uint32_t display[0x20];
+
+	uint32_t frames[LATENCY_BUCKETS];
+	uint32_t ms[LATENCY_BUCKETS];
+	uint32_t samples;
+	uint32_t overlapped;
+	uint32_t timeouts;
+	int64_t cycles_sum;
+	int64_t host_sum;
+	int64_t host_max;
+	int64_t last;                       // ns, latest sample
+} latency;
+
+void latency_input(latency *l, const uint32_t *display, int32_t cycle, uint32_t frame, int64_t now);
+int latency_display(latency *l, const uint32_t *display, int32_t cycle, uint32_t frame, int64_t now);
+void latency_report(latency *l, FILE *f, int cpu_rate);
+
+#endif
@@ -0,0 +1,111 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * layout.c
+ *
+ *************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "layout.h"
+
+// map file from LAYOUT_DIR and point into it. Returns the number of
+// segments, -1 if the file is missing or not a layout.
+
+int layout_open(layout *l, const char *file)
+{
+	const layout_header *hdr;
+	char path[512];
+	int x;
+
+	memset(l, 0, sizeof(layout));
+	snprintf(path, sizeof(path), "%s%s", LAYOUT_DIR, file);
+
+#ifndef _WIN32
+	struct stat st;
+	int fd = open(path, O_RDONLY);
+
+	if(fd >= 0) {
+		if(fstat(fd, &st) == 0 && st.st_size > 0) {
+			l->data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+			if(l->data == MAP_FAILED)
+				l->data = NULL;
+			else {
+				l->size = st.st_size;
+				l->mapped = 1;
+			}
+		}
+		close(fd);
+	}
+#else
+	FILE *f = fopen(path, "rb");
+	uint8_t *data;
+	long len;
+
+	if(f) {
+		fseek(f, 0, SEEK_END);
+		len = ftell(f);
+		fseek(f, 0, SEEK_SET);
+		if(len > 0 && (data = malloc(len)) && fread(data, 1, len, f) == (size_t)len) {
+			l->data = data;
+			l->size = len;
+		}
+		fclose(f);
+	}
+#endif
+
+	if(!l->data) {
+		printf("Failed to load layout %s\n", path);
+		return -1;
+	}
+
+	hdr = (const layout_header *)l->data;
+	if(l->size < (int)sizeof(layout_header) || hdr->magic != LAYOUT_MAGIC || hdr->version != LAYOUT_VERSION ||
+	   hdr->assets > LAYOUT_ASSETS ||
+	   l->size < (int)(sizeof(layout_header) + hdr->segments * sizeof(layout_seg) + hdr->assets * LAYOUT_NAME)) {
+		printf("Bad layout %s\n", path);
+		layout_close(l);
+		return -1;
+	}
+
+	l->count = hdr->segments;
+	l->segs = (const layout_seg *)(hdr + 1);
+	l->assets = hdr->assets;
+	l->names = (const char (*)[LAYOUT_NAME])(l->segs + l->count);
+
+	// a plate is a bit of a 32 bit display row
+	for(x = 0; x < l->count; x++) {
+		if(l->segs[x].plate >= 32) {
+			printf("Bad layout %s: segment %d has plate %d\n", path, x, l->segs[x].plate);
+			layout_close(l);
+			return -1;
+		}
+	}
+
+	return l->count;
+}
+
+void layout_close(layout *l)
+{
+#ifndef _WIN32
+	if(l->mapped)
+		munmap((void *)l->data, l->size);
+	else
+#endif
+		free((void *)l->data);
+
+	memset(l, 0, sizeof(layout));
+}
@@ -0,0 +1,61 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * layout.h
+ *
+ *************************/
+
+#ifndef _LAYOUT_H_
+#define _LAYOUT_H_
+
+#include <stdint.h>
+
+// SEGMENT LAYOUTS
+//
+// A layout says where each lit grid/plate segment is drawn and with which
+// image. vfdlayout compiles res/layout/<driver>.txt into a .lay blob:
+// header, segments in draw order, then fixed size image names. The blob
+// is little endian and mapped as is, nothing is parsed at startup.
+
+#define LAYOUT_DIR      "res/layout/"
+#define LAYOUT_MAGIC    0x4c444656      // "VFDL"
+#define LAYOUT_VERSION  1
+#define LAYOUT_NAME     32
+#define LAYOUT_ASSETS   256
+
+typedef struct _layout_header {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t segments;
+	uint16_t assets;
+	uint16_t pad[3];
+} layout_header;
+
+typedef struct _layout_seg {
+	uint8_t grid;
+	uint8_t plate;
+	int16_t x;
+	int16_t y;
+	uint16_t asset;
+} layout_seg;
+
+typedef struct _layout {
+	const uint8_t *data;
+	int size;
+	int mapped;
+
+	int count;
+	const layout_seg *segs;
+	int assets;
+	const char (*names)[LAYOUT_NAME];
+} layout;
+
+int layout_open(layout *l, const char *file);
+void layout_close(layout *l);
+
+#endif
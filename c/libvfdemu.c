@@ -0,0 +1,229 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * libvfdemu.c
+ *
+ *************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libvfdemu.h"
+#include "machine.h"
+#include "driver.h"
+#include "savestate.h"
+
+#define AUDIO_RING 10240
+
+struct _vfd_machine {
+	vfd_game *game;
+	ucom4cpu cpu;
+	uint8_t inputs[INPUTS_NUM];
+	void *state;
+
+	vfd_input_cb input;
+	vfd_display_cb display;
+	vfd_audio_cb audio;
+	void *user;
+
+	uint8_t rom[UCOM4_ROM_SIZE];        // own copy, the caller's buffer may go away
+	uint8_t audio_ring[AUDIO_RING];
+	int audio_pos;                      // next sample handed to the audio callback
+};
+
+int vfd_api_version(void)
+{
+	return VFDEMU_API_VERSION;
+}
+
+const char *vfd_driver_name(int index)
+{
+	int x;
+
+	for(x = 0; vfd_drivers[x]; x++)
+		if(x == index)
+			return vfd_drivers[x]->name;
+
+	return NULL;
+}
+
+vfd_machine *vfd_create(const char *driver)
+{
+	vfd_machine *m;
+	vfd_game *game = driver_find(driver);
+
+	if(!game)
+		return NULL;
+
+	m = calloc(1, sizeof(vfd_machine));
+	if(!m)
+		return NULL;
+
+	m->game = game;
+	if(m->game->state_size && !(m->state = calloc(1, m->game->state_size))) {
+		free(m);
+		return NULL;
+	}
+
+	machine_attach(&m->cpu, m->game, m->inputs, m->state);
+	m->cpu.rom = m->rom;
+	m->cpu.audio_buf = m->audio_ring;
+	vfd_reset(m);
+
+	return m;
+}
+
+void vfd_destroy(vfd_machine *m)
+{
+	if(!m)
+		return;
+
+	free(m->state);
+	free(m);
+}
+
+int vfd_rom_size(vfd_machine *m)
+{
+	return m->game->romsize;
+}
+
+// the rom survives vfd_reset, load it once after vfd_create
+
+int vfd_load_rom(vfd_machine *m, const uint8_t *data, int size)
+{
+	if(size != m->game->romsize || size > UCOM4_ROM_SIZE)
+		return 0;
+
+	memcpy(m->rom, data, size);
+	vfd_reset(m);
+
+	return size;
+}
+
+void vfd_reset(vfd_machine *m)
+{
+	int rate = m->cpu.sound_frequency;
+
+	ucom4_reset(&m->cpu);
+	m->cpu.cpu_rate = 100000;
+	m->cpu.sound_frequency = rate;
+	m->audio_pos = m->cpu.aindex;
+
+	memset(m->inputs, 0, sizeof(m->inputs));
+	if(m->state)
+		memset(m->state, 0, m->game->state_size);
+}
+
+void vfd_set_callbacks(vfd_machine *m, vfd_input_cb input, vfd_display_cb display, vfd_audio_cb audio, void *user)
+{
+	m->input = input;
+	m->display = display;
+	m->audio = audio;
+	m->user = user;
+}
+
+// 0 turns sample generation off
+void vfd_set_audio_rate(vfd_machine *m, int rate)
+{
+	m->cpu.sound_frequency = rate;
+	m->cpu.sample_count = 0;
+}
+
+void vfd_set_input(vfd_machine *m, int line, int on)
+{
+	if(line >= 0 && line < INPUTS_NUM)
+		m->inputs[line] = on ? 1 : 0;
+}
+
+void vfd_set_inputs(vfd_machine *m, uint32_t bits)
+{
+	int x;
+
+	for(x = 0; x < INPUTS_NUM; x++)
+		m->inputs[x] = (bits >> x) & 1;
+}
+
+static void lib_audio(vfd_machine *m)
+{
+	int count;
+
+	// the ring may wrap, hand it over in at most two pieces
+	while(m->cpu.audio_avail > 0) {
+		count = m->cpu.audio_avail;
+		if(count > AUDIO_RING - m->audio_pos)
+			count = AUDIO_RING - m->audio_pos;
+
+		if(m->audio)
+			m->audio(m, m->audio_ring + m->audio_pos, count, m->user);
+
+		m->audio_pos = (m->audio_pos + count) % AUDIO_RING;
+		m->cpu.audio_avail -= count;
+	}
+}
+
+// run for cycles more cycles, frame by frame. Returns the cycles the cpu
+// executed, which can be off by the instruction that crossed the end.
+
+int32_t vfd_run(vfd_machine *m, int32_t cycles)
+{
+	int32_t left = cycles, done = 0, ticks;
+
+	while(left > 0) {
+		ticks = left < VFDEMU_FRAME_CYCLES ? left : VFDEMU_FRAME_CYCLES;
+
+		if(m->input)
+			m->input(m, m->user);
+
+		done += ucom4_exec(&m->cpu, ticks);
+		left -= ticks;
+
+		if(m->display)
+			m->display(m, m->cpu.display_cache, m->cpu.display_maxy, m->cpu.display_maxx, m->user);
+		lib_audio(m);
+	}
+
+	return done;
+}
+
+const uint32_t *vfd_get_display(vfd_machine *m, int *nrows, int *ncols)
+{
+	if(nrows)
+		*nrows = m->cpu.display_maxy;
+	if(ncols)
+		*ncols = m->cpu.display_maxx;
+
+	return m->cpu.display_cache;
+}
+
+uint32_t vfd_cycles(vfd_machine *m)
+{
+	return (uint32_t)m->cpu.totalticks;
+}
+
+int vfd_state_size(vfd_machine *m)
+{
+	return savestate_size(&m->cpu);
+}
+
+int vfd_state_save(vfd_machine *m, uint8_t *buf, int size)
+{
+	return savestate_save(&m->cpu, buf, size);
+}
+
+int vfd_state_load(vfd_machine *m, const uint8_t *buf, int size)
+{
+	int len = savestate_load(&m->cpu, buf, size);
+
+	// samples from before the load are stale
+	if(len) {
+		m->audio_pos = m->cpu.aindex;
+		m->cpu.audio_avail = 0;
+	}
+
+	return len;
+}
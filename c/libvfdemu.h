@@ -0,0 +1,65 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * libvfdemu.h
+ *
+ * Embedding API of libvfdemu.a / libvfdemu.so. Self contained, does not
+ * pull in SDL or the emulator headers. Every machine carries all of its
+ * own state, so any number can run side by side.
+ *
+ *************************/
+
+#ifndef _LIBVFDEMU_H_
+#define _LIBVFDEMU_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VFDEMU_API_VERSION  1
+#define VFDEMU_FRAME_CYCLES 2000        // callbacks run once per frame, 50 fps
+
+typedef struct _vfd_machine vfd_machine;
+
+// before every frame, may change the input lines
+typedef void (*vfd_input_cb)(vfd_machine *m, void *user);
+// after every frame: display rows, bit x of row y is one segment
+typedef void (*vfd_display_cb)(vfd_machine *m, const uint32_t *rows, int nrows, int ncols, void *user);
+// after every frame: unsigned 8 bit mono samples at the rate set with vfd_set_audio_rate
+typedef void (*vfd_audio_cb)(vfd_machine *m, const uint8_t *samples, int count, void *user);
+
+int vfd_api_version(void);
+const char *vfd_driver_name(int index);     // NULL past the last driver
+
+vfd_machine *vfd_create(const char *driver);
+void vfd_destroy(vfd_machine *m);
+
+int vfd_rom_size(vfd_machine *m);
+int vfd_load_rom(vfd_machine *m, const uint8_t *data, int size);
+void vfd_reset(vfd_machine *m);
+
+void vfd_set_callbacks(vfd_machine *m, vfd_input_cb input, vfd_display_cb display, vfd_audio_cb audio, void *user);
+void vfd_set_audio_rate(vfd_machine *m, int rate);
+void vfd_set_input(vfd_machine *m, int line, int on);
+void vfd_set_inputs(vfd_machine *m, uint32_t bits);
+
+int32_t vfd_run(vfd_machine *m, int32_t cycles);
+const uint32_t *vfd_get_display(vfd_machine *m, int *nrows, int *ncols);
+uint32_t vfd_cycles(vfd_machine *m);
+
+int vfd_state_size(vfd_machine *m);
+int vfd_state_save(vfd_machine *m, uint8_t *buf, int size);
+int vfd_state_load(vfd_machine *m, const uint8_t *buf, int size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,45 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * machine.c
+ *
+ * State and helpers shared by the drivers and every frontend
+ *
+ *************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "machine.h"
+#include "driver.h"
+#include "romset.h"
+
+#define VOLUME 200
+
+// point the cpu at the game's rom, mapped and checked by the registry
+
+int load_rom(ucom4cpu *cpu, vfd_game *game)
+{
+	cpu->rom = romset_map(game->rom, game->romsize, game->romcrc, game->romsha1);
+
+	return cpu->rom ? game->romsize : 0;
+}
+
+// wire a cpu to its driver, input lines and driver state block, all
+// owned by the caller
+
+void machine_attach(ucom4cpu *cpu, vfd_game *game, uint8_t *in, void *state)
+{
+	cpu->game = game;
+	cpu->inputs = in;
+	cpu->state = state;
+}
+
+void level_w(ucom4cpu *cpu, uint8_t data) {
+	data *=VOLUME;
+	cpu->audio_level = data;
+}
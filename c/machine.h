@@ -0,0 +1,30 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * machine.h
+ *
+ * What the drivers and the headless users need from machine.c, without
+ * SDL. The frontends get it through vfd_emu.h.
+ *
+ *************************/
+
+#ifndef _MACHINE_H_
+#define _MACHINE_H_
+
+#include <stdint.h>
+#include "ucom4_cpu.h"
+
+#define INPUTS_NUM          20
+
+struct _gamedriver;
+
+void level_w(ucom4cpu *cpu, uint8_t data);
+int load_rom(ucom4cpu *cpu, struct _gamedriver *game);
+void machine_attach(ucom4cpu *cpu, struct _gamedriver *game, uint8_t *in, void *state);
+
+#endif
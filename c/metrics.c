@@ -0,0 +1,177 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * metrics.c
+ *
+ *************************/
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#endif
+
+#include "metrics.h"
+
+#define METRICS_POLL_MS 200
+
+atomic_llong metrics[METRICS];
+
+static const char *metric_names[METRICS] = {
+	"vfd_instructions_total",
+	"vfd_cycles_total",
+	"vfd_frames_rendered_total",
+	"vfd_frames_skipped_total",
+	"vfd_audio_underruns_total",
+	"vfd_audio_overruns_total",
+	"vfd_audio_avail",
+	"vfd_input_latency_us",
+	"vfd_render_us",
+	"vfd_render_max_us",
+};
+
+static pthread_t server;
+static int server_fd = -1;
+static int server_quit;
+static char server_path[108];
+
+void metrics_max(int metric, long long value)
+{
+	long long old = metrics_get(metric);
+
+	while(value > old &&
+	      !atomic_compare_exchange_weak_explicit(&metrics[metric], &old, value,
+	                                             memory_order_relaxed, memory_order_relaxed))
+		;
+}
+
+// "name value" per line, what the socket hands out
+
+int metrics_text(char *buf, int size)
+{
+	int len = 0, x;
+
+	for(x=0;x<METRICS && len < size;x++)
+		len += snprintf(buf + len, size - len, "%s %lld\n", metric_names[x], metrics_get(x));
+
+	return len < size ? len : size - 1;
+}
+
+// one short line for the console
+
+void metrics_line(FILE *f)
+{
+	fprintf(f, "Stats: %lld instr %lld cycles, %lld drawn %lld skipped, audio %lld avail %lld under %lld over, latency %lld us, render %lld us (max %lld)\n",
+		metrics_get(METRIC_INSTRUCTIONS), metrics_get(METRIC_CYCLES),
+		metrics_get(METRIC_FRAMES_RENDERED), metrics_get(METRIC_FRAMES_SKIPPED),
+		metrics_get(METRIC_AUDIO_AVAIL), metrics_get(METRIC_AUDIO_UNDERRUNS),
+		metrics_get(METRIC_AUDIO_OVERRUNS), metrics_get(METRIC_INPUT_LATENCY_US),
+		metrics_get(METRIC_RENDER_US), metrics_get(METRIC_RENDER_MAX_US));
+}
+
+#ifndef _WIN32
+
+static void *metrics_server(void *data)
+{
+	struct pollfd p;
+	char buf[1024];
+	int fd, len, done, n;
+
+	(void)data;
+
+	p.fd = server_fd;
+	p.events = POLLIN;
+
+	while(!__atomic_load_n(&server_quit, __ATOMIC_ACQUIRE)) {
+		if(poll(&p, 1, METRICS_POLL_MS) <= 0)
+			continue;
+
+		if((fd = accept(server_fd, NULL, NULL)) < 0)
+			continue;
+
+		// a reader that goes away early only loses its own answer,
+		// MSG_NOSIGNAL keeps SIGPIPE from taking the emulator with it
+		len = metrics_text(buf, sizeof(buf));
+		for(done = 0; done < len; done += n) {
+			n = send(fd, buf + done, len - done, MSG_NOSIGNAL);
+			if(n < 0 && errno == EINTR)
+				n = 0;
+			else if(n <= 0)
+				break;              // EPIPE / ECONNRESET, the reader closed
+		}
+		close(fd);
+	}
+
+	return NULL;
+}
+
+// a stale socket at path is replaced, anything else there is left alone
+
+int metrics_serve(const char *path)
+{
+	struct sockaddr_un addr;
+	struct stat st;
+
+	if(strlen(path) >= sizeof(addr.sun_path))
+		return -1;
+
+	if(lstat(path, &st) == 0 && !S_ISSOCK(st.st_mode)) {
+		printf("%s exists and is not a socket\n", path);
+		return -1;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+
+	if((server_fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+		return -1;
+
+	unlink(path);
+	if(bind(server_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(server_fd, 4) < 0 ||
+	   pthread_create(&server, NULL, metrics_server, NULL)) {
+		close(server_fd);
+		server_fd = -1;
+		return -1;
+	}
+
+	strcpy(server_path, path);
+
+	return 0;
+}
+
+void metrics_close(void)
+{
+	if(server_fd < 0)
+		return;
+
+	__atomic_store_n(&server_quit, 1, __ATOMIC_RELEASE);
+	pthread_join(server, NULL);
+	close(server_fd);
+	unlink(server_path);
+	server_fd = -1;
+}
+
+#else
+
+int metrics_serve(const char *path)
+{
+	return -1;
+}
+
+void metrics_close(void)
+{
+}
+
+#endif
@@ -0,0 +1,63 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * metrics.h
+ *
+ *************************/
+
+#ifndef _METRICS_H_
+#define _METRICS_H_
+
+#include <stdio.h>
+#include <stdatomic.h>
+
+// METRICS
+//
+// Relaxed atomic counters and gauges, cheap enough to bump from the
+// emulation and audio threads. metrics_text() formats them as
+// "name value" lines, metrics_serve() answers every connection on a
+// unix socket with that text and closes it.
+
+enum {
+	METRIC_INSTRUCTIONS = 0,
+	METRIC_CYCLES,
+	METRIC_FRAMES_RENDERED,
+	METRIC_FRAMES_SKIPPED,
+	METRIC_AUDIO_UNDERRUNS,
+	METRIC_AUDIO_OVERRUNS,
+	METRIC_AUDIO_AVAIL,                 // gauges from here on
+	METRIC_INPUT_LATENCY_US,
+	METRIC_RENDER_US,
+	METRIC_RENDER_MAX_US,
+	METRICS
+};
+
+extern atomic_llong metrics[METRICS];
+
+static inline void metrics_add(int metric, long long value)
+{
+	atomic_fetch_add_explicit(&metrics[metric], value, memory_order_relaxed);
+}
+
+static inline void metrics_set(int metric, long long value)
+{
+	atomic_store_explicit(&metrics[metric], value, memory_order_relaxed);
+}
+
+static inline long long metrics_get(int metric)
+{
+	return atomic_load_explicit(&metrics[metric], memory_order_relaxed);
+}
+
+void metrics_max(int metric, long long value);
+int metrics_text(char *buf, int size);
+void metrics_line(FILE *f);
+int metrics_serve(const char *path);
+void metrics_close(void);
+
+#endif
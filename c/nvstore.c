@@ -0,0 +1,188 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * nvstore.c
+ *
+ *************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/time.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "nvstore.h"
+
+__thread int nvstore_hold = 0;
+
+// data changed: take a copy for the flusher, from the thread writing it
+
+void nvstore_touch(nvstore *s)
+{
+	if(nvstore_hold || !s->shadow)
+		return;
+
+	// a touch that leaves the block as last copied is not a change
+	pthread_mutex_lock(&s->copy_lock);
+	if(memcmp(s->shadow, s->data, s->size)) {
+		memcpy(s->shadow, s->data, s->size);
+		atomic_fetch_add_explicit(&s->dirty, 1, memory_order_release);
+	}
+	pthread_mutex_unlock(&s->copy_lock);
+}
+
+// write the last touched contents if they changed since the last flush
+
+int nvstore_flush(nvstore *s)
+{
+	char tmp[1040];
+	uint8_t *copy;
+	unsigned dirty;
+	FILE *f;
+	int ok;
+
+	if(atomic_load_explicit(&s->dirty, memory_order_acquire) == s->flushed)
+		return 1;
+
+	copy = malloc(s->size);
+	if(!copy)
+		return 0;
+
+	pthread_mutex_lock(&s->copy_lock);
+	memcpy(copy, s->shadow, s->size);
+	dirty = atomic_load_explicit(&s->dirty, memory_order_relaxed);
+	pthread_mutex_unlock(&s->copy_lock);
+
+	snprintf(tmp, sizeof(tmp), "%s.tmp", s->path);
+	f = fopen(tmp, "wb");
+	if(!f) {
+		printf("ERROR: cannot write %s: %s\n", tmp, strerror(errno));
+		free(copy);
+		return 0;
+	}
+
+	ok = fwrite(copy, s->size, 1, f) == 1 && fflush(f) == 0;
+#ifndef _WIN32
+	if(ok && s->sync)
+		ok = fsync(fileno(f)) == 0;
+#endif
+	ok = (fclose(f) == 0) && ok;
+	free(copy);
+
+#ifdef _WIN32
+	remove(s->path);
+#endif
+	if(!ok || rename(tmp, s->path)) {
+		printf("ERROR: writing %s to disk failed.\n", s->path);
+		remove(tmp);
+		return 0;
+	}
+
+	s->flushed = dirty;
+	return 1;
+}
+
+static void *nvstore_worker(void *data)
+{
+	nvstore *s = data;
+	struct timeval now;
+	struct timespec until;
+	unsigned seen;
+
+	pthread_mutex_lock(&s->lock);
+	while(!s->quit) {
+		seen = atomic_load_explicit(&s->dirty, memory_order_acquire);
+
+		gettimeofday(&now, NULL);
+		until.tv_sec = now.tv_sec + s->debounce_ms / 1000;
+		until.tv_nsec = now.tv_usec * 1000 + (s->debounce_ms % 1000) * 1000000L;
+		if(until.tv_nsec >= 1000000000L) {
+			until.tv_sec++;
+			until.tv_nsec -= 1000000000L;
+		}
+		pthread_cond_timedwait(&s->wake, &s->lock, &until);
+
+		// flush once the contents have been still for a whole window
+		if(s->quit || seen == s->flushed)
+			continue;
+		if(seen == atomic_load_explicit(&s->dirty, memory_order_acquire) || ++s->waited >= NVSTORE_MAX_WAIT) {
+			nvstore_flush(s);
+			s->waited = 0;
+		}
+	}
+	pthread_mutex_unlock(&s->lock);
+
+	return NULL;
+}
+
+// load path into data if it exists, then keep it written behind.
+// Returns 1 if the file was loaded.
+
+int nvstore_open(nvstore *s, const char *path, void *data, int size, int debounce_ms, int sync)
+{
+	FILE *f;
+	int loaded = 0;
+
+	memset(s, 0, sizeof(nvstore));
+	snprintf(s->path, sizeof(s->path), "%s", path);
+	s->data = data;
+	s->size = size;
+	s->sync = sync;
+	s->debounce_ms = debounce_ms > 0 ? debounce_ms : NVSTORE_DEBOUNCE_MS;
+	atomic_init(&s->dirty, 0);
+
+	f = fopen(path, "rb");
+	if(f) {
+		if(fread(data, size, 1, f) == 1)
+			loaded = 1;
+		else
+			printf("ERROR: reading %s from disk failed.\n", path);
+		fclose(f);
+	}
+
+	s->shadow = malloc(size);
+	if(!s->shadow) {
+		s->data = NULL;
+		return loaded;
+	}
+	memcpy(s->shadow, data, size);
+	pthread_mutex_init(&s->copy_lock, NULL);
+
+	pthread_mutex_init(&s->lock, NULL);
+	pthread_cond_init(&s->wake, NULL);
+	if(pthread_create(&s->thread, NULL, nvstore_worker, s) == 0)
+		s->started = 1;
+
+	return loaded;
+}
+
+// stop the flusher and write whatever is still pending
+
+void nvstore_close(nvstore *s)
+{
+	if(s->started) {
+		pthread_mutex_lock(&s->lock);
+		s->quit = 1;
+		pthread_cond_signal(&s->wake);
+		pthread_mutex_unlock(&s->lock);
+		pthread_join(s->thread, NULL);
+		s->started = 0;
+	}
+
+	if(s->data) {
+		nvstore_flush(s);
+		pthread_mutex_destroy(&s->copy_lock);
+	}
+	free(s->shadow);
+	s->shadow = NULL;
+	s->data = NULL;
+}
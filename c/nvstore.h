@@ -0,0 +1,62 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * nvstore.h
+ *
+ *************************/
+
+#ifndef _NVSTORE_H_
+#define _NVSTORE_H_
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+// WRITE BEHIND NON VOLATILE STORAGE
+//
+// Keeps a block of emulated non volatile memory in a file. After each
+// change the emulation copies the block into a shadow and bumps a dirty
+// counter; a flusher thread writes the shadow once it has been left
+// alone for the debounce window, and once more on close. The flusher
+// never reads the live block.
+// Files are replaced through a temporary and a rename, so a crash leaves
+// either the old or the new contents.
+
+#define NVSTORE_DEBOUNCE_MS 500
+#define NVSTORE_MAX_WAIT    10          // windows, flush even if it keeps changing
+
+typedef struct _nvstore {
+	char path[1024];
+	const void *data;
+	uint8_t *shadow;                    // data as of the last touch
+	int size;
+	int sync;                           // fsync before the rename
+
+	atomic_uint dirty;                  // bumped after every change to data
+	unsigned flushed;                   // dirty count the file matches
+	int debounce_ms;
+	int waited;                         // windows a pending change has waited
+
+	pthread_mutex_t copy_lock;          // shadow and dirty move together
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	int started;
+	int quit;
+} nvstore;
+
+int nvstore_open(nvstore *s, const char *path, void *data, int size, int debounce_ms, int sync);
+void nvstore_close(nvstore *s);
+int nvstore_flush(nvstore *s);
+void nvstore_touch(nvstore *s);
+
+// set by a thread while it runs frames it will roll back (run-ahead);
+// their changes are not written
+extern __thread int nvstore_hold;
+
+#endif
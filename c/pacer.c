@@ -0,0 +1,125 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * pacer.c
+ *
+ *************************/
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "pacer.h"
+
+int64_t pacer_now(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+
+	return (int64_t)t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+static void pacer_sleep_until(int64_t when)
+{
+	struct timespec t;
+
+#ifdef __linux__
+	t.tv_sec = when / 1000000000;
+	t.tv_nsec = when % 1000000000;
+	// returns the error, only a signal is worth another go
+	while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, NULL) == EINTR)
+		;
+#else
+	int64_t left = when - pacer_now();
+
+	if(left <= 0)
+		return;
+	t.tv_sec = left / 1000000000;
+	t.tv_nsec = left % 1000000000;
+	nanosleep(&t, NULL);
+#endif
+}
+
+void pacer_init(pacer *p, int fps)
+{
+	memset(p, 0, sizeof(pacer));
+	p->period = 1000000000 / fps;
+	pacer_reset(p);
+}
+
+// next frame is due right away
+
+void pacer_reset(pacer *p)
+{
+	p->deadline = pacer_now();
+}
+
+int pacer_due(pacer *p)
+{
+	return pacer_now() >= p->deadline;
+}
+
+// a frame was taken, account for how late it was and move on
+
+void pacer_advance(pacer *p)
+{
+	int64_t late = pacer_now() - p->deadline;
+
+	if(late < 0)
+		late = 0;
+
+	p->frames++;
+	p->jitter_sum += late;
+	if(late > p->jitter_max)
+		p->jitter_max = late;
+	if(late >= p->period)
+		p->late++;
+
+	p->deadline += p->period;
+
+	// too far behind to catch up, don't run a burst of frames
+	if(late >= p->period * PACER_MAX_BEHIND) {
+		p->deadline = pacer_now() + p->period;
+		p->resyncs++;
+	}
+}
+
+// sleep until the frame is due; 0 if pending() had input first
+
+int pacer_wait(pacer *p, int (*pending)(void))
+{
+	int64_t now, until;
+
+	for(;;) {
+		if(pending && pending()) {
+			p->early_wakes++;
+			return 0;
+		}
+
+		now = pacer_now();
+		if(now >= p->deadline)
+			return 1;
+
+		until = p->deadline;
+		if(pending && until - now > PACER_SLICE_NS)
+			until = now + PACER_SLICE_NS;
+
+		pacer_sleep_until(until);
+	}
+}
+
+void pacer_report(pacer *p)
+{
+	if(!p->frames)
+		return;
+
+	printf("Pacing: %u frames, jitter avg %.3f ms max %.3f ms, %u late, %u resyncs, %u input wakes\n",
+		p->frames, p->jitter_sum / 1e6 / p->frames, p->jitter_max / 1e6,
+		p->late, p->resyncs, p->early_wakes);
+}
@@ -0,0 +1,48 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * pacer.h
+ *
+ *************************/
+
+#ifndef _PACER_H_
+#define _PACER_H_
+
+#include <stdint.h>
+
+// FRAME PACING
+//
+// Frame deadlines on the monotonic clock. pacer_wait() sleeps up to the
+// next deadline in PACER_SLICE_NS steps so pending input can cut the
+// sleep short, pacer_due()/pacer_advance() take the frame once it is time.
+// Lateness against each deadline is kept for the jitter report.
+
+#define PACER_SLICE_NS  4000000         // longest sleep between input checks
+#define PACER_MAX_BEHIND 5              // frames late before the deadline resyncs
+
+typedef struct _pacer {
+	int64_t period;                     // ns
+	int64_t deadline;
+
+	uint32_t frames;
+	uint32_t late;                      // taken a full period or more after the deadline
+	uint32_t resyncs;
+	uint32_t early_wakes;               // sleeps cut short by input
+	int64_t jitter_sum;
+	int64_t jitter_max;
+} pacer;
+
+int64_t pacer_now(void);
+void pacer_init(pacer *p, int fps);
+void pacer_reset(pacer *p);
+int pacer_due(pacer *p);
+void pacer_advance(pacer *p);
+int pacer_wait(pacer *p, int (*pending)(void));
+void pacer_report(pacer *p);
+
+#endif
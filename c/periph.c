@@ -0,0 +1,42 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * periph.c
+ *
+ *************************/
+#include "periph.h"
+
+// set the pins in mask to value, logging it if anything changed
+
+void periph_write(periph_bus *bus, const periph_type *type, void *device, uint16_t mask, uint16_t value)
+{
+	uint16_t pins = (bus->pins & ~mask) | (value & mask);
+
+	if(pins == bus->pins)
+		return;
+
+	if(bus->count == PERIPH_LOG)
+		periph_sync(bus, type, device);
+
+	bus->log[bus->count++] = pins;
+	bus->pins = pins;
+}
+
+// bring the device up to date with every logged change
+
+void periph_sync(periph_bus *bus, const periph_type *type, void *device)
+{
+	int x;
+
+	for(x = 0; x < bus->count; x++) {
+		type->pins(device, bus->applied, bus->log[x]);
+		bus->applied = bus->log[x];
+	}
+
+	bus->count = 0;
+}
@@ -0,0 +1,45 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * periph.h
+ *
+ *************************/
+
+#ifndef _PERIPH_H_
+#define _PERIPH_H_
+
+#include <stdint.h>
+
+// CLOCKED PERIPHERALS
+//
+// A serial chip hanging off cpu ports sees its input pins through a
+// periph_bus. Port writes only log pin changes; the device model replays
+// them in order when the driver is about to read one of its outputs, or
+// when the log fills up. A device that acts on every write, changed or
+// not, gives itself a pin the driver toggles on each one. The bus is
+// plain data and lives in the driver state block, so it is saved with it.
+
+#define PERIPH_LOG 32
+
+typedef struct _periph_bus {
+	uint16_t pins;                      // as last written by the cpu
+	uint16_t applied;                   // as last seen by the device
+	uint8_t count;
+	uint16_t log[PERIPH_LOG];
+} periph_bus;
+
+typedef struct _periph_type {
+	const char *name;
+	// one pin change, in order: pins were old, are now pins
+	void (*pins)(void *device, uint16_t old, uint16_t pins);
+} periph_type;
+
+void periph_write(periph_bus *bus, const periph_type *type, void *device, uint16_t mask, uint16_t value);
+void periph_sync(periph_bus *bus, const periph_type *type, void *device);
+
+#endif
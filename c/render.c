@@ -0,0 +1,81 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * render.c
+ *
+ *************************/
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "driver.h"
+#include "render.h"
+
+// GRAPHICS REGISTRY
+// the drawing half of each driver in vfd_drivers[]
+
+vfd_gfx *vfd_gfx_drivers[] = {
+	&gfx_astrowars,
+	&gfx_caveman,
+	&gfx_sonytaax44,
+	NULL
+};
+
+static const vfd_gfx *gfx_find(const vfd_game *game)
+{
+	vfd_gfx **gfx;
+
+	for(gfx = vfd_gfx_drivers; *gfx; gfx++)
+		if((*gfx)->game == game)
+			return *gfx;
+
+	return NULL;
+}
+
+vfd_render *render_create(vfd_game *game, ucom4cpu *cpu)
+{
+	const vfd_gfx *gfx = gfx_find(game);
+	vfd_render *r;
+
+	if(!gfx) {
+		printf("%s: no graphics\n", game->name);
+		return NULL;
+	}
+
+	r = calloc(1, sizeof(vfd_render));
+	if(!r)
+		return NULL;
+
+	r->game = game;
+	r->gfx = gfx;
+	r->cpu = cpu;
+	gfx->setup_gfx(r);
+
+	if(!r->w || !r->h) {
+		render_destroy(r);
+		return NULL;
+	}
+
+	return r;
+}
+
+void render_update(vfd_render *r)
+{
+	if(r->out)
+		r->gfx->display_update(r);
+}
+
+// the driver frees what it loaded, out belongs to the caller
+
+void render_destroy(vfd_render *r)
+{
+	if(!r)
+		return;
+
+	r->gfx->close_gfx(r);
+	free(r);
+}
@@ -0,0 +1,66 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * render.h
+ *
+ *************************/
+
+#ifndef _RENDER_H_
+#define _RENDER_H_
+
+#include <SDL.h>
+#include "ucom4_cpu.h"
+#include "layout.h"
+#include "segload.h"
+
+// RENDER CONTEXT
+//
+// Everything a driver needs to draw one machine. setup_gfx() loads into
+// the context and sets w x h, or leaves them 0 if that failed (a missing
+// or bad layout). display_update() draws cpu's display into
+// out, which the caller owns and flips. Any number of contexts, of any
+// drivers, can be alive at once.
+// The drawing half of each driver lives in its *_gfx.c, outside the
+// core the library is built from.
+
+struct _gamedriver;
+struct _vfd_render;
+
+typedef struct _vfd_gfx {
+	struct _gamedriver *game;
+	void (*setup_gfx)(struct _vfd_render *r);
+	void (*close_gfx)(struct _vfd_render *r);
+	void (*display_update)(struct _vfd_render *r);
+} vfd_gfx;
+
+// every driver's drawing half, NULL terminated (render.c)
+extern vfd_gfx *vfd_gfx_drivers[];
+extern vfd_gfx gfx_astrowars;
+extern vfd_gfx gfx_caveman;
+extern vfd_gfx gfx_sonytaax44;
+
+typedef struct _vfd_render {
+	struct _gamedriver *game;
+	const vfd_gfx *gfx;
+	ucom4cpu *cpu;                      // whose display_cache is drawn
+	SDL_Surface *out;                   // w x h, the window or a tile
+	int w, h;
+
+	// owned by the driver
+	SDL_Surface *bg;
+	SDL_Surface *bezel;
+	SDL_Surface *vfd;                   // segments before the bezel goes on
+	layout layout;
+	segload segs;
+} vfd_render;
+
+vfd_render *render_create(struct _gamedriver *game, ucom4cpu *cpu);
+void render_update(vfd_render *r);
+void render_destroy(vfd_render *r);
+
+#endif
@@ -0,0 +1,336 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * replay.c
+ *
+ *************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <sys/time.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "vfd_emu.h"
+#include "driver.h"
+#include "replay.h"
+#include "savestate.h"
+
+struct input_event events[MAX_EVENTS], *pevent = NULL;
+
+int replay_count = 0;
+
+struct state_hash *hashes = NULL, *phash = NULL;
+int hash_count = 0;
+int hash_size = 0;
+
+int replay_verify = 0;
+uint8_t replay_nvram[REPLAY_NVRAM_MAX];
+int replay_nvram_size = -1;             // no N line
+savestate_view last_view;
+int last_valid = 0;
+
+FILE *record_file = NULL;
+int record_hash = 0;
+
+int replay_load(char *file)
+{
+	FILE *f = fopen(file,"r");
+	char line[256];
+	struct state_hash h;
+
+	if(!f) {
+		printf("Cannot open replay file\n");
+		return -1;
+	}
+
+	pevent = events;
+	replay_nvram_size = -1;
+
+	while(fgets(line, sizeof(line), f)) {
+		if(line[0] == 'N' && line[1] == ' ') {
+			for(replay_nvram_size = 0; replay_nvram_size < REPLAY_NVRAM_MAX &&
+			    1 == sscanf(line + 2 + replay_nvram_size * 2, "%2hhx", &replay_nvram[replay_nvram_size]);
+			    replay_nvram_size++)
+				;
+		} else if(2 == sscanf(line, "H %" SCNx32 " %" SCNx64, &h.cycle, &h.hash)) {
+			if(hash_count == hash_size) {
+				hash_size = hash_size ? hash_size * 2 : 4096;
+				hashes = realloc(hashes, hash_size * sizeof(struct state_hash));
+			}
+			hashes[hash_count++] = h;
+		} else if(pevent < events + MAX_EVENTS - 1 &&
+		          2 == sscanf(line, "%x %hhx", &(pevent->cycle), &(pevent->val))) {
+			pevent++;
+		}
+	}
+
+	fclose(f);
+
+	replay_count = pevent - events;
+	printf("replaying %d events, %d state hashes\n", replay_count, hash_count);
+	pevent->cycle = 0;
+	pevent = events;
+	phash = hashes;
+
+	return replay_count;
+}
+
+// Load only the input events of a replay into a new array, for machines
+// that keep their own stream. Returns NULL if the file cannot be read.
+
+struct input_event *replay_load_stream(char *file, int *count)
+{
+	FILE *f = fopen(file,"r");
+	struct input_event *stream = NULL, ev;
+	char line[256];
+	int size = 0;
+
+	*count = 0;
+
+	if(!f) {
+		printf("Cannot open replay file\n");
+		return NULL;
+	}
+
+	while(fgets(line, sizeof(line), f)) {
+		if(2 != sscanf(line, "%x %hhx", &ev.cycle, &ev.val))
+			continue;
+		if(*count == size) {
+			size = size ? size * 2 : 4096;
+			stream = realloc(stream, size * sizeof(struct input_event));
+		}
+		stream[(*count)++] = ev;
+	}
+
+	fclose(f);
+
+	if(!stream)
+		stream = malloc(sizeof(struct input_event));
+
+	return stream;
+}
+
+void replay_apply(uint8_t *in, uint8_t val)
+{
+	int x;
+
+	for(x=0;x<INPUTS_NUM;x++) {
+		in[x]=(val & (1<<x)) ? 1:0;
+	}
+}
+
+// put the replay's NVRAM image into cpu's machine, before it runs
+
+void replay_nvram_load(ucom4cpu *cpu)
+{
+	uint8_t *nvram;
+	int size;
+
+	if(!cpu->game->nvram)
+		return;
+
+	nvram = cpu->game->nvram(cpu, &size);
+	memset(nvram, 0, size);
+
+	if(replay_nvram_size == size)
+		memcpy(nvram, replay_nvram, size);
+	else if(replay_nvram_size >= 0)
+		printf("Replay NVRAM has %d bytes, %s has %d, starting empty\n", replay_nvram_size, cpu->game->name, size);
+}
+
+// Compare against the recorded hash for the current cycle.
+// Returns 0 on the first divergence, after dumping the state.
+
+int replay_check(ucom4cpu *cpu)
+{
+	savestate_view view;
+	uint64_t hash;
+
+	if(!phash)
+		return 1;
+
+	// a frame boundary the replay never stopped at means timing diverged
+	if(phash < hashes + hash_count && phash->cycle < (uint32_t)cpu->totalticks) {
+		printf("Replay diverged: no frame ended at %08x (now at %08x)\n", phash->cycle, cpu->totalticks);
+		goto diverged;
+	}
+
+	if(phash >= hashes + hash_count || phash->cycle != (uint32_t)cpu->totalticks)
+		return 1;
+
+	savestate_get_view(cpu, &view);
+	hash = savestate_hash(&view);
+
+	if(hash != phash->hash) {
+		printf("Replay diverged at %08x: hash %016" PRIx64 ", recorded %016" PRIx64 "\n",
+			phash->cycle, hash, phash->hash);
+		printf("-- state now\n");
+		savestate_dump_view(&view);
+		goto diverged;
+	}
+
+	last_view = view;
+	last_valid = 1;
+	phash++;
+
+	return 1;
+
+diverged:
+	if(last_valid) {
+		printf("-- state at last matching frame\n");
+		savestate_dump_view(&last_view);
+	}
+	return 0;
+}
+
+// Run the whole replay headless, jumping straight from one event cycle
+// to the next. No display updates, no SDL polling and no frame pacing.
+// When verifying it also stops at every recorded frame hash.
+
+int replay_run_fast(ucom4cpu *cpu)
+{
+	struct timeval start, end;
+	double wall, emulated;
+	uint32_t target;
+	int32_t ticks;
+	int result = 1;
+
+	gettimeofday(&start, NULL);
+
+	pevent = events;
+	phash = hashes;
+
+	while(pevent < events + replay_count || (replay_verify && phash < hashes + hash_count)) {
+		target = UINT32_MAX;
+		if(pevent < events + replay_count)
+			target = pevent->cycle;
+		if(replay_verify && phash < hashes + hash_count && phash->cycle < target)
+			target = phash->cycle;
+
+		ticks = (int32_t)(target - cpu->totalticks);
+		if(ticks > 0)
+			ucom4_exec(cpu, ticks);
+
+		if(replay_verify && !replay_check(cpu)) {
+			result = 0;
+			break;
+		}
+
+		while(pevent < events + replay_count && pevent->cycle <= (uint32_t)cpu->totalticks) {
+			replay_apply(cpu->inputs, pevent->val);
+			pevent++;
+		}
+	}
+
+	gettimeofday(&end, NULL);
+
+	pevent = NULL;
+
+	wall = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1000000.0;
+	emulated = (double)cpu->totalticks / cpu->cpu_rate;
+
+	printf("Replay: %d events, %08x cycles\n", replay_count, cpu->totalticks);
+	printf("Replay: %.3f emulated s in %.6f wall s (%.1f emulated s/wall s)\n",
+		emulated, wall, wall > 0 ? emulated / wall : 0);
+	if(replay_verify)
+		printf("Replay: %s (%d state hashes checked)\n", result ? "verified" : "FAILED", (int)(phash - hashes));
+
+	return result;
+}
+
+int replay_record_open(ucom4cpu *cpu, char *file, int hash)
+{
+	uint8_t *nvram;
+	int size, x;
+
+	record_file = fopen(file, "w+");
+
+	if(!record_file) {
+		printf("Cannot open record file\n");
+		return -1;
+	}
+
+	record_hash = hash;
+
+	if(cpu->game->nvram) {
+		nvram = cpu->game->nvram(cpu, &size);
+		if(size > REPLAY_NVRAM_MAX)
+			size = 0;
+		fprintf(record_file, "N ");
+		for(x=0;x<size;x++)
+			fprintf(record_file, "%02x", nvram[x]);
+		fprintf(record_file, "\n");
+	}
+
+	return 0;
+}
+
+void replay_record_event(ucom4cpu *cpu, uint8_t val)
+{
+	if(record_file)
+		fprintf(record_file, "%08x %02x\n", cpu->totalticks, val);
+}
+
+void replay_record_frame(ucom4cpu *cpu)
+{
+	savestate_view view;
+
+	if(!record_file || !record_hash)
+		return;
+
+	savestate_get_view(cpu, &view);
+	fprintf(record_file, "H %08x %016" PRIx64 "\n", cpu->totalticks, savestate_hash(&view));
+}
+
+// the machine was taken back to cycle (rewind, quick load): drop the
+// events from cycle on and the hashes after it, recording goes on from there
+
+void replay_record_truncate(uint32_t cycle)
+{
+	char line[256];
+	unsigned c;
+	long keep = 0;
+
+	if(!record_file)
+		return;
+
+	fseek(record_file, 0, SEEK_SET);
+	while(fgets(line, sizeof(line), record_file)) {
+		if(line[0] == 'N') {
+			// the starting NVRAM stays
+		} else if(sscanf(line, "H %x", &c) == 1) {
+			if(c > cycle)
+				break;
+		} else if(sscanf(line, "%x", &c) != 1 || c >= cycle)
+			break;
+		keep = ftell(record_file);
+	}
+
+	fflush(record_file);
+#ifdef _WIN32
+	_chsize(_fileno(record_file), keep);
+#else
+	if(ftruncate(fileno(record_file), keep))
+		printf("Cannot truncate record file\n");
+#endif
+	fseek(record_file, keep, SEEK_SET);
+}
+
+void replay_record_close(void)
+{
+	if(record_file) {
+		fclose(record_file);
+		record_file = NULL;
+	}
+}
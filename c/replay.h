@@ -0,0 +1,59 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * replay.h
+ *
+ *************************/
+
+#ifndef _REPLAY_H_
+#define _REPLAY_H_
+
+#include <stdint.h>
+#include "ucom4_cpu.h"
+
+#define MAX_EVENTS 65535
+#define REPLAY_NVRAM_MAX 120            // bytes, one line of hex
+
+// RECORD + PLAYBACK
+//
+// replay file lines:
+//   <cycle> <inputs>          input change, hex
+//   H <cycle> <hash>          state hash at the end of a frame, hex
+//   N <bytes>                 the machine's NVRAM at the start, hex
+//
+// A replay starts from the NVRAM it was recorded with, or an empty one
+// if the file has none; NVRAM.bin is neither read nor written.
+
+struct input_event {
+	uint32_t cycle;
+	uint8_t val;
+};
+
+struct state_hash {
+	uint32_t cycle;
+	uint64_t hash;
+};
+
+extern struct input_event events[MAX_EVENTS], *pevent;
+extern int replay_count;
+extern int replay_verify;
+
+int replay_load(char *file);
+struct input_event *replay_load_stream(char *file, int *count);
+void replay_apply(uint8_t *in, uint8_t val);
+void replay_nvram_load(ucom4cpu *cpu);
+int replay_check(ucom4cpu *cpu);
+int replay_run_fast(ucom4cpu *cpu);
+
+int replay_record_open(ucom4cpu *cpu, char *file, int hash);
+void replay_record_event(ucom4cpu *cpu, uint8_t val);
+void replay_record_frame(ucom4cpu *cpu);
+void replay_record_truncate(uint32_t cycle);
+void replay_record_close(void);
+
+#endif
@@ -0,0 +1,178 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * rewind.c
+ *
+ *************************/
+#include <stdlib.h>
+#include <string.h>
+
+#include "rewind.h"
+
+// a delta is a list of records:
+// [zero run lo][zero run hi][literal len lo][literal len hi][literal bytes...]
+// literal bytes are a ^ b, a literal only ends on 4 or more unchanged bytes
+
+#define RLE_MAX     0xfff0
+#define RLE_BREAK   4
+
+static int rle_xor_encode(const uint8_t *a, const uint8_t *b, int n, uint8_t *out)
+{
+	int i = 0, j, o = 0, k;
+	int zeros, start;
+
+	while(i < n) {
+		zeros = 0;
+		while(i < n && a[i] == b[i] && zeros < RLE_MAX) {
+			i++;
+			zeros++;
+		}
+
+		start = i;
+		while(i < n && i - start < RLE_MAX) {
+			if(a[i] == b[i]) {
+				for(j = i; j < n && j - i < RLE_BREAK && a[j] == b[j]; j++);
+				if(j - i == RLE_BREAK || j == n)
+					break;
+				i = j;
+				continue;
+			}
+			i++;
+		}
+
+		out[o++] = zeros & 0xff;
+		out[o++] = zeros >> 8;
+		out[o++] = (i - start) & 0xff;
+		out[o++] = (i - start) >> 8;
+		for(k = start; k < i; k++)
+			out[o++] = a[k] ^ b[k];
+	}
+
+	return o;
+}
+
+static void rle_xor_apply(uint8_t *dst, const uint8_t *rle, int len)
+{
+	const uint8_t *end = rle + len;
+	int zeros, lit;
+
+	while(rle < end) {
+		zeros = rle[0] | rle[1] << 8;
+		lit   = rle[2] | rle[3] << 8;
+		rle  += 4;
+		dst  += zeros;
+		while(lit--)
+			*dst++ ^= *rle++;
+	}
+}
+
+rewind_buffer *rewind_create(int frames, int state_size)
+{
+	rewind_buffer *rw = calloc(1, sizeof(rewind_buffer));
+
+	if(!rw)
+		return NULL;
+
+	rw->frames     = frames;
+	rw->state_size = state_size;
+	rw->slots      = calloc(frames, sizeof(rewind_slot));
+	rw->current    = malloc(state_size);
+	// each record skips at least RLE_BREAK bytes for its 4 byte header
+	rw->scratch    = malloc(state_size * 2 + 8);
+
+	if(!rw->slots || !rw->current || !rw->scratch) {
+		rewind_destroy(rw);
+		return NULL;
+	}
+
+	return rw;
+}
+
+void rewind_destroy(rewind_buffer *rw)
+{
+	int x;
+
+	if(!rw)
+		return;
+
+	if(rw->slots) {
+		for(x=0;x<rw->frames;x++)
+			free(rw->slots[x].data);
+		free(rw->slots);
+	}
+	free(rw->current);
+	free(rw->scratch);
+	free(rw);
+}
+
+// store the newest state, keeping the way back to the previous one
+
+void rewind_push(rewind_buffer *rw, const uint8_t *state)
+{
+	rewind_slot *slot;
+	int len;
+
+	if(!rw->has_current) {
+		memcpy(rw->current, state, rw->state_size);
+		rw->has_current = 1;
+		return;
+	}
+
+	len = rle_xor_encode(rw->current, state, rw->state_size, rw->scratch);
+
+	slot = &rw->slots[rw->head];
+
+	if(len > slot->size) {
+		uint8_t *data = realloc(slot->data, len);
+		if(!data)
+			return;
+		slot->data = data;
+		slot->size = len;
+	}
+
+	// when full this drops the oldest frame
+	rw->bytes -= slot->len;
+	memcpy(slot->data, rw->scratch, len);
+	slot->len = len;
+	rw->bytes += len;
+
+	rw->head = (rw->head + 1) % rw->frames;
+	if(rw->count < rw->frames)
+		rw->count++;
+
+	memcpy(rw->current, state, rw->state_size);
+}
+
+// step one frame back, returns the state to load or NULL when out of history
+
+const uint8_t *rewind_step(rewind_buffer *rw)
+{
+	rewind_slot *slot;
+
+	if(!rw->count)
+		return NULL;
+
+	rw->head = (rw->head + rw->frames - 1) % rw->frames;
+	slot = &rw->slots[rw->head];
+
+	rle_xor_apply(rw->current, slot->data, slot->len);
+
+	rw->bytes -= slot->len;
+	slot->len = 0;
+	rw->count--;
+
+	return rw->current;
+}
+
+double rewind_bytes_per_second(rewind_buffer *rw, int fps)
+{
+	if(!rw->count)
+		return 0;
+
+	return (double)rw->bytes * fps / rw->count;
+}
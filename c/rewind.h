@@ -0,0 +1,45 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * rewind.h
+ *
+ *************************/
+
+#ifndef _REWIND_H_
+#define _REWIND_H_
+
+#include <stdint.h>
+
+// One save state per frame, stored as the run length encoded XOR delta
+// against the frame after it. Only the newest state is kept in full.
+
+typedef struct _rewind_slot {
+	uint8_t *data;
+	int len;
+	int size;
+} rewind_slot;
+
+typedef struct _rewind_buffer {
+	rewind_slot *slots;
+	int frames;          // capacity in frames
+	int head;            // next slot to write
+	int count;           // frames of history available
+	int state_size;
+	int bytes;           // encoded bytes held in slots
+	uint8_t *current;    // newest full state
+	int has_current;
+	uint8_t *scratch;    // encoder output, worst case size
+} rewind_buffer;
+
+rewind_buffer *rewind_create(int frames, int state_size);
+void rewind_destroy(rewind_buffer *rw);
+void rewind_push(rewind_buffer *rw, const uint8_t *state);
+const uint8_t *rewind_step(rewind_buffer *rw);
+double rewind_bytes_per_second(rewind_buffer *rw, int fps);
+
+#endif
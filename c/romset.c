@@ -0,0 +1,263 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * romset.c
+ *
+ *************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "romset.h"
+#include "ucom4_cpu.h"
+
+typedef struct _romset_file {
+	char path[1024];
+	const uint8_t *data;                // NULL if the file failed to load or verify
+	int size;
+	int mapped;                         // data is an mmap of size bytes, else malloc'd
+	struct _romset_file *next;
+} romset_file;
+
+static romset_file *romset_files;
+static pthread_mutex_t romset_lock = PTHREAD_MUTEX_INITIALIZER;
+static char romset_dir[1024] = ROMSET_DIR;
+
+void romset_set_dir(const char *dir)
+{
+	pthread_mutex_lock(&romset_lock);
+	snprintf(romset_dir, sizeof(romset_dir), "%s", dir);
+	pthread_mutex_unlock(&romset_lock);
+}
+
+uint32_t romset_crc32(const uint8_t *data, int len)
+{
+	static uint32_t table[256];
+	uint32_t crc = 0xFFFFFFFF, c;
+	int x, k;
+
+	if(!table[1]) {
+		for(x = 0; x < 256; x++) {
+			for(c = x, k = 0; k < 8; k++)
+				c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+			table[x] = c;
+		}
+	}
+
+	for(x = 0; x < len; x++)
+		crc = table[(crc ^ data[x]) & 0xFF] ^ (crc >> 8);
+
+	return crc ^ 0xFFFFFFFF;
+}
+
+#define ROL(v,n) (((v) << (n)) | ((v) >> (32 - (n))))
+
+static void sha1_block(uint32_t h[5], const uint8_t *p)
+{
+	uint32_t w[80], a, b, c, d, e, f, k, t;
+	int x;
+
+	for(x = 0; x < 16; x++)
+		w[x] = (uint32_t)p[x*4] << 24 | p[x*4+1] << 16 | p[x*4+2] << 8 | p[x*4+3];
+	for(; x < 80; x++)
+		w[x] = ROL(w[x-3] ^ w[x-8] ^ w[x-14] ^ w[x-16], 1);
+
+	a = h[0]; b = h[1]; c = h[2]; d = h[3]; e = h[4];
+
+	for(x = 0; x < 80; x++) {
+		if(x < 20)      { f = (b & c) | (~b & d);          k = 0x5A827999; }
+		else if(x < 40) { f = b ^ c ^ d;                   k = 0x6ED9EBA1; }
+		else if(x < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+		else            { f = b ^ c ^ d;                   k = 0xCA62C1D6; }
+
+		t = ROL(a, 5) + f + e + k + w[x];
+		e = d; d = c; c = ROL(b, 30); b = a; a = t;
+	}
+
+	h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+}
+
+void romset_sha1(const uint8_t *data, int len, char hex[41])
+{
+	uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+	uint8_t tail[128];
+	uint64_t bits = (uint64_t)len * 8;
+	int x, rest, pad;
+
+	for(x = 0; x + 64 <= len; x += 64)
+		sha1_block(h, data + x);
+
+	// last partial block, the 0x80 marker and the bit length
+	rest = len - x;
+	memset(tail, 0, sizeof(tail));
+	memcpy(tail, data + x, rest);
+	tail[rest] = 0x80;
+	pad = rest < 56 ? 64 : 128;
+	for(x = 0; x < 8; x++)
+		tail[pad - 1 - x] = bits >> (x * 8);
+
+	sha1_block(h, tail);
+	if(pad == 128)
+		sha1_block(h, tail + 64);
+
+	for(x = 0; x < 5; x++)
+		sprintf(hex + x * 8, "%08x", h[x]);
+}
+
+// map the whole file, or read it where there is no mmap
+
+static const uint8_t *romset_load(const char *path, int *size, int *mapped)
+{
+	uint8_t *data = NULL;
+
+#ifndef _WIN32
+	struct stat st;
+	int fd = open(path, O_RDONLY);
+
+	*mapped = 0;
+	if(fd < 0)
+		return NULL;
+
+	if(fstat(fd, &st) == 0 && st.st_size > 0) {
+		data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if(data == MAP_FAILED)
+			data = NULL;
+		else {
+			*size = st.st_size;
+			*mapped = 1;
+		}
+	}
+	close(fd);
+#else
+	FILE *f = fopen(path, "rb");
+
+	*mapped = 0;
+	if(!f)
+		return NULL;
+
+	fseek(f, 0, SEEK_END);
+	*size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	if(*size > 0 && (data = malloc(*size)) && fread(data, 1, *size, f) != (size_t)*size) {
+		free(data);
+		data = NULL;
+	}
+	fclose(f);
+#endif
+
+	return data;
+}
+
+static void romset_unload(romset_file *rf)
+{
+	if(!rf->data)
+		return;
+
+#ifndef _WIN32
+	if(rf->mapped)
+		munmap((void *)rf->data, rf->size);
+	else
+#endif
+		free((void *)rf->data);
+
+	rf->data = NULL;
+}
+
+static int romset_verify(romset_file *rf, int size, uint32_t crc, const char *sha1)
+{
+	char hex[41];
+	uint32_t c;
+
+	if(rf->size != size) {
+		printf("ROM [%s] is 0x%X bytes, expected 0x%X\n", rf->path, rf->size, size);
+		return 0;
+	}
+
+	if(crc && (c = romset_crc32(rf->data, rf->size)) != crc) {
+		printf("ROM [%s] CRC32 %08x, expected %08x\n", rf->path, c, crc);
+		return 0;
+	}
+
+	if(sha1 && sha1[0]) {
+		romset_sha1(rf->data, rf->size, hex);
+		if(strcmp(hex, sha1)) {
+			printf("ROM [%s] SHA1 %s, expected %s\n", rf->path, hex, sha1);
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+// returns UCOM4_ROM_SIZE readable bytes, or NULL
+
+const uint8_t *romset_map(const char *file, int size, uint32_t crc, const char *sha1)
+{
+	romset_file *rf;
+	char path[1024];
+	const uint8_t *data;
+	uint8_t *padded;
+
+	pthread_mutex_lock(&romset_lock);
+
+	snprintf(path, sizeof(path), "%s%s", romset_dir, file);
+	for(rf = romset_files; rf; rf = rf->next)
+		if(!strcmp(rf->path, path))
+			break;
+
+	if(!rf && (rf = calloc(1, sizeof(romset_file)))) {
+		snprintf(rf->path, sizeof(rf->path), "%s", path);
+		rf->next = romset_files;
+		romset_files = rf;
+
+		rf->data = romset_load(path, &rf->size, &rf->mapped);
+		if(!rf->data)
+			printf("Failed to open rom [%s]\n", path);
+		else if(!romset_verify(rf, size, crc, sha1))
+			romset_unload(rf);
+
+		// the core reads a full rom's worth, pad short ones
+		if(rf->data && rf->size < UCOM4_ROM_SIZE) {
+			padded = calloc(1, UCOM4_ROM_SIZE);
+			if(padded)
+				memcpy(padded, rf->data, rf->size);
+			romset_unload(rf);
+			rf->data = padded;
+			rf->mapped = 0;
+		}
+	}
+
+	data = rf && rf->data && rf->size == size ? rf->data : NULL;
+
+	pthread_mutex_unlock(&romset_lock);
+
+	return data;
+}
+
+// unmap everything, no cpu may still point at a rom
+
+void romset_close(void)
+{
+	romset_file *rf;
+
+	pthread_mutex_lock(&romset_lock);
+	while((rf = romset_files)) {
+		romset_files = rf->next;
+		romset_unload(rf);
+		free(rf);
+	}
+	pthread_mutex_unlock(&romset_lock);
+}
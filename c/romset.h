@@ -0,0 +1,34 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * romset.h
+ *
+ *************************/
+
+#ifndef _ROMSET_H_
+#define _ROMSET_H_
+
+#include <stdint.h>
+
+// ROM REGISTRY
+//
+// Every rom file is mapped read only once per process and shared by all
+// the cpus that run it. Its size, CRC32 and SHA1 are checked against
+// what the driver declares the first time it is mapped; a file that
+// fails stays failed.
+
+#define ROMSET_DIR "res/"
+
+const uint8_t *romset_map(const char *file, int size, uint32_t crc, const char *sha1);
+void romset_set_dir(const char *dir);
+void romset_close(void);
+
+uint32_t romset_crc32(const uint8_t *data, int len);
+void romset_sha1(const uint8_t *data, int len, char hex[41]);
+
+#endif
@@ -0,0 +1,139 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * savestate.c
+ *
+ *************************/
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "machine.h"
+#include "driver.h"
+#include "savestate.h"
+#include "nvstore.h"
+
+// the rom and the host side hooks at the end are not part of the state,
+// copy the struct around them
+
+#define CPU_SIZE      offsetof(ucom4cpu, game)
+
+int savestate_size(ucom4cpu *cpu)
+{
+	return sizeof(savestate_header) + CPU_SIZE + INPUTS_NUM + cpu->game->state_size;
+}
+
+int savestate_save(ucom4cpu *cpu, uint8_t *buf, int size)
+{
+	savestate_header *hdr = (savestate_header *)buf;
+	int len = savestate_size(cpu);
+
+	if(size < len)
+		return 0;
+
+	hdr->magic       = SAVESTATE_MAGIC;
+	hdr->version     = SAVESTATE_VERSION;
+	hdr->cpu_size    = CPU_SIZE;
+	hdr->inputs_size = INPUTS_NUM;
+	hdr->driver_size = cpu->game->state_size;
+	memset(hdr->game, 0, sizeof(hdr->game));
+	memcpy(hdr->game, cpu->game->name, strnlen(cpu->game->name, sizeof(hdr->game) - 1));
+	buf += sizeof(savestate_header);
+
+	memcpy(buf, cpu, CPU_SIZE);
+	buf += CPU_SIZE;
+
+	memcpy(buf, cpu->inputs, INPUTS_NUM);
+	buf += INPUTS_NUM;
+
+	if(cpu->game->state_size)
+		memcpy(buf, cpu->state, cpu->game->state_size);
+
+	return len;
+}
+
+int savestate_load(ucom4cpu *cpu, const uint8_t *buf, int size)
+{
+	const savestate_header *hdr = (const savestate_header *)buf;
+
+	if(size < (int)sizeof(savestate_header) || size < savestate_size(cpu))
+		return 0;
+
+	if(hdr->magic != SAVESTATE_MAGIC || hdr->version != SAVESTATE_VERSION)
+		return 0;
+
+	if(hdr->cpu_size != CPU_SIZE || hdr->inputs_size != INPUTS_NUM ||
+	   hdr->driver_size != cpu->game->state_size ||
+	   strncmp(hdr->game, cpu->game->name, sizeof(hdr->game)))
+		return 0;
+
+	buf += sizeof(savestate_header);
+
+	memcpy(cpu, buf, CPU_SIZE);
+	buf += CPU_SIZE;
+
+	memcpy(cpu->inputs, buf, INPUTS_NUM);
+	buf += INPUTS_NUM;
+
+	if(cpu->game->state_size)
+		memcpy(cpu->state, buf, cpu->game->state_size);
+
+	// the loaded state brings its own non volatile memory, the file follows
+	if(cpu->store)
+		nvstore_touch(cpu->store);
+
+	return savestate_size(cpu);
+}
+
+void savestate_get_view(ucom4cpu *cpu, savestate_view *view)
+{
+	memcpy(view->display_cache, cpu->display_cache, sizeof(view->display_cache));
+	memcpy(view->ram, cpu->ram, sizeof(view->ram));
+	view->pc        = cpu->pc;
+	view->acc       = cpu->acc;
+	view->dpl       = cpu->dpl;
+	view->dph       = cpu->dph;
+	view->carry_f   = cpu->carry_f;
+	view->carry_s_f = cpu->carry_s_f;
+	view->skip      = cpu->skip;
+	view->timer_f   = cpu->timer_f;
+	view->int_f     = cpu->int_f;
+	view->inte_f    = cpu->inte_f;
+	view->pad       = 0;
+}
+
+// 64 bit FNV-1a
+
+uint64_t savestate_hash(const savestate_view *view)
+{
+	const uint8_t *p = (const uint8_t *)view;
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	int x;
+
+	for(x=0;x<(int)sizeof(savestate_view);x++) {
+		hash ^= p[x];
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+void savestate_dump_view(const savestate_view *view)
+{
+	int x;
+
+	printf("PC %03X ACC %X DP %X%X C %d CS %d SKIP %d TIMER %d INT %d INTE %d\n",
+		view->pc, view->acc, view->dph, view->dpl, view->carry_f, view->carry_s_f,
+		view->skip, view->timer_f, view->int_f, view->inte_f);
+
+	for(x=0;x<0x80;x++)
+		printf("%s%X%s", (x & 0xf) ? "" : "RAM ", view->ram[x], (x & 0xf) == 0xf ? "\n" : "");
+
+	for(x=0;x<0x20;x++)
+		printf("%s%08X%s", (x & 0x7) ? " " : "VFD ", view->display_cache[x], (x & 0x7) == 0x7 ? "\n" : "");
+}
@@ -0,0 +1,59 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * savestate.h
+ *
+ *************************/
+
+#ifndef _SAVESTATE_H_
+#define _SAVESTATE_H_
+
+#include <stdint.h>
+#include "ucom4_cpu.h"
+
+#define SAVESTATE_MAGIC    0x34535356    // "VSS4"
+#define SAVESTATE_VERSION  1
+
+// blob layout: header, cpu (without rom), input lines, driver state
+
+typedef struct _savestate_header {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t cpu_size;
+	uint16_t inputs_size;
+	uint16_t driver_size;
+	char game[16];
+} savestate_header;
+
+// packed view of the state that replays are verified against
+
+typedef struct _savestate_view {
+	uint32_t display_cache[0x20];
+	uint8_t ram[0x80];
+	uint16_t pc;
+	uint8_t acc;
+	uint8_t dpl;
+	uint8_t dph;
+	uint8_t carry_f;
+	uint8_t carry_s_f;
+	uint8_t skip;
+	uint8_t timer_f;
+	uint8_t int_f;
+	uint8_t inte_f;
+	uint8_t pad;
+} savestate_view;
+
+int savestate_size(ucom4cpu *cpu);
+int savestate_save(ucom4cpu *cpu, uint8_t *buf, int size);
+int savestate_load(ucom4cpu *cpu, const uint8_t *buf, int size);
+
+void savestate_get_view(ucom4cpu *cpu, savestate_view *view);
+uint64_t savestate_hash(const savestate_view *view);
+void savestate_dump_view(const savestate_view *view);
+
+#endif
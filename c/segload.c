@@ -0,0 +1,176 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * segload.c
+ *
+ *************************/
+#include <stdio.h>
+#include <string.h>
+#include <dirent.h>
+#include <SDL_image.h>
+
+#include "segload.h"
+
+static SDL_Surface *segload_decode(segload *s, int asset)
+{
+	char filename[512];
+	SDL_Surface *surface;
+
+	snprintf(filename, sizeof(filename), "%s%.*s", s->dir, LAYOUT_NAME, s->layout->names[asset]);
+	surface = IMG_Load(filename);
+
+	// the surface has to be in place before anyone sees READY
+	s->surface[asset] = surface;
+	atomic_store_explicit(&s->status[asset], surface ? SEGLOAD_READY : SEGLOAD_FAILED, memory_order_release);
+	atomic_fetch_add_explicit(&s->decoded, 1, memory_order_release);
+
+	return surface;
+}
+
+static void *segload_worker(void *data)
+{
+	segload *s = data;
+	int asset;
+
+	pthread_mutex_lock(&s->lock);
+	for(;;) {
+		while(s->head == s->tail && !s->quit)
+			pthread_cond_wait(&s->wake, &s->lock);
+		if(s->quit)
+			break;
+		asset = s->queue[s->head++];
+		pthread_mutex_unlock(&s->lock);
+
+		segload_decode(s, asset);
+
+		pthread_mutex_lock(&s->lock);
+	}
+	pthread_mutex_unlock(&s->lock);
+
+	return NULL;
+}
+
+// images of layout l from dir (ending in '/'), start the loader. Only
+// the images found in the directory are ever loaded, the others are not
+// drawn. Returns the number found.
+
+int segload_open(segload *s, const char *dir, const layout *l)
+{
+	DIR *d;
+	struct dirent *e;
+	int x, found = 0;
+
+	memset(s, 0, sizeof(segload));
+	snprintf(s->dir, sizeof(s->dir), "%s", dir);
+	s->layout = l;
+	atomic_init(&s->decoded, 0);
+
+	for(x = 0; x < l->assets; x++)
+		atomic_init(&s->status[x], SEGLOAD_FAILED);
+
+	d = opendir(dir);
+	if(!d) {
+		printf("Failed to open %s\n", dir);
+		return 0;
+	}
+
+	while((e = readdir(d))) {
+		for(x = 0; x < l->assets; x++) {
+			if(atomic_load_explicit(&s->status[x], memory_order_relaxed) == SEGLOAD_FAILED &&
+			   !strncmp(e->d_name, l->names[x], LAYOUT_NAME) && strlen(e->d_name) <= LAYOUT_NAME) {
+				atomic_store_explicit(&s->status[x], SEGLOAD_ON_DISK, memory_order_relaxed);
+				found++;
+			}
+		}
+	}
+	closedir(d);
+
+	if(found < l->assets)
+		printf("%s: %d of %d images missing\n", dir, l->assets - found, l->assets);
+
+	pthread_mutex_init(&s->lock, NULL);
+	pthread_cond_init(&s->wake, NULL);
+	if(pthread_create(&s->thread, NULL, segload_worker, s) == 0)
+		s->started = 1;
+
+	return found;
+}
+
+// the image's surface, or NULL while it is missing or still loading
+
+SDL_Surface *segload_get(segload *s, int asset)
+{
+	int status;
+
+	if(asset < 0 || asset >= LAYOUT_ASSETS)
+		return NULL;
+
+	status = atomic_load_explicit(&s->status[asset], memory_order_acquire);
+	if(status == SEGLOAD_READY)
+		return s->surface[asset];
+
+	if(status == SEGLOAD_ON_DISK) {
+		// without a loader thread decode it right here
+		if(!s->started)
+			return segload_decode(s, asset);
+
+		atomic_store_explicit(&s->status[asset], SEGLOAD_QUEUED, memory_order_relaxed);
+		pthread_mutex_lock(&s->lock);
+		s->queue[s->tail++] = asset;
+		pthread_cond_signal(&s->wake);
+		pthread_mutex_unlock(&s->lock);
+	}
+
+	return NULL;
+}
+
+void segload_close(segload *s)
+{
+	int x;
+
+	if(s->started) {
+		pthread_mutex_lock(&s->lock);
+		s->quit = 1;
+		pthread_cond_signal(&s->wake);
+		pthread_mutex_unlock(&s->lock);
+		pthread_join(s->thread, NULL);
+		s->started = 0;
+	}
+
+	for(x = 0; x < LAYOUT_ASSETS; x++) {
+		if(s->surface[x]) {
+			SDL_FreeSurface(s->surface[x]);
+			s->surface[x] = NULL;
+		}
+		atomic_store(&s->status[x], SEGLOAD_NONE);
+	}
+}
+
+// blit every lit segment of the layout onto dst, in layout order
+
+void segload_draw(segload *s, const uint32_t *display, SDL_Surface *dst)
+{
+	const layout_seg *seg;
+	SDL_Surface *image;
+	SDL_Rect rect;
+	int x;
+
+	for(x = 0; x < s->layout->count; x++) {
+		seg = &s->layout->segs[x];
+		if(seg->grid >= 0x20 || !(display[seg->grid] & 1 << seg->plate))
+			continue;
+		if(!(image = segload_get(s, seg->asset)))
+			continue;
+
+		rect.x = seg->x;
+		rect.y = seg->y;
+		rect.w = image->w;
+		rect.h = image->h;
+		SDL_BlitSurface(image, NULL, dst, &rect);
+	}
+}
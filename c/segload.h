@@ -0,0 +1,59 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * segload.h
+ *
+ *************************/
+
+#ifndef _SEGLOAD_H_
+#define _SEGLOAD_H_
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <SDL.h>
+#include "layout.h"
+
+// LAZY SEGMENT LOADER
+//
+// The images named by a layout live in one directory. Open only lists
+// the directory to see which are there, none is decoded; an image is
+// decoded by a background thread the first time it is asked for, until
+// then it is not drawn. Missing images are never drawn. decoded moves each time one
+// becomes ready, a frontend that only draws on changes draws again then.
+
+enum {
+	SEGLOAD_NONE = 0,                   // not in the layout
+	SEGLOAD_ON_DISK,
+	SEGLOAD_QUEUED,
+	SEGLOAD_READY,
+	SEGLOAD_FAILED
+};
+
+typedef struct _segload {
+	char dir[255];
+	const layout *layout;
+	atomic_uchar status[LAYOUT_ASSETS];
+	SDL_Surface *surface[LAYOUT_ASSETS];
+	atomic_uint decoded;                // images finished loading
+
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	int started;
+	int quit;
+	int queue[LAYOUT_ASSETS];
+	int head, tail;
+} segload;
+
+int segload_open(segload *s, const char *dir, const layout *l);
+SDL_Surface *segload_get(segload *s, int asset);
+void segload_draw(segload *s, const uint32_t *display, SDL_Surface *dst);
+void segload_close(segload *s);
+
+#endif
@@ -1,11 +1,12 @@
 #include <stdbool.h>
 #include <stdint.h>
-#include <SDL.h>
+#include <stdlib.h>
 #include "driver.h"
-#include "vfd_emu.h"
+#include "machine.h"
 #include "astrowars.h"
-
-#include "lib/SDL_rotozoom.h"
+#include "nvstore.h"
+#include "periph.h"
+#include "vfdlog.h"
 
 #define TAAX44_GRID_A       (0)
 #define TAAX44_GRID_B       (1)
@@ -14,24 +15,6 @@
 #define TAAX44_GRID_E       (4)
 #define TAAX44_GRID_F       (5)
 
-vfd_game game_sonytaax44 = {
-	.prepare_display    = sonytaax44_prepare_display,
-	.rom                = "D553C-200.rom",
-	.romsize            = 0x800,
-	.setup_gfx          = sonytaax44_setup_gfx,
-	.close_gfx          = sonytaax44_close_gfx,
-	.display_update     = sonytaax44_display_update,
-	.input_r            = sonytaax44_input_r,
-	.output_w           = sonytaax44_output_w,
-	.name               = "sonytaax44"
-};
-
-SDL_Surface *gfx[10][15];
-SDL_Surface *bg,*bezel,*vfd_display, *tmpscreen;
-
-int gfx_x[50][50];
-int gfx_y[50][50];
-
 typedef struct
 {
     bool        clock_old;
@@ -47,6 +30,7 @@ typedef struct
     uint8_t     address;
     uint16_t    data;
     uint16_t    cells[16];
+    uint8_t     data_out;       /* level of the D I/O terminal when reading */
 } t_NVRAM;
 
 #define NVRAM_SB                (0U)
@@ -58,8 +42,40 @@ typedef struct
 #define NVRAM_READ              (6U)
 #define NVRAM_MCTNS             (7U)
 
-t_asp_processor ASP;
-t_NVRAM         NVRAM;
+typedef struct
+{
+    t_asp_processor ASP;
+    t_NVRAM         NVRAM;
+    int             relay_drive_act;
+    periph_bus      asp_bus;        /* E0 strobe, E1 data, E2 clock */
+    periph_bus      nvram_bus;      /* see NVRAM_PIN_* */
+} t_sonytaax44_state;
+
+/* NVRAM pins on its periph bus */
+#define NVRAM_PIN_CLOCK         (0x001U)        /* E2 */
+#define NVRAM_PIN_DATA          (0x002U)        /* E1 */
+#define NVRAM_PIN_WRITE         (0x004U)        /* toggles on every port E write */
+#define NVRAM_PIN_MODE          (0x070U)        /* I0-I2 */
+#define NVRAM_PIN_ADDR          (0xF00U)        /* H0-H3 */
+
+// state of the machine the cpu belongs to
+#define TAAX44(cpu)     ((t_sonytaax44_state *)(cpu)->state)
+
+vfd_game game_sonytaax44 = {
+	.prepare_display    = sonytaax44_prepare_display,
+	.rom                = "D553C-200.bin",
+	.romsize            = 0x800,
+	.romcrc             = 0xcda172e5,
+	.romsha1            = "47efd87d6f287a46b8207e20fe9252744206cbc3",
+	.layout             = "sonytaax44.lay",
+	.open_store         = sonytaax44_open_store,
+	.close_store        = sonytaax44_close_store,
+	.nvram              = sonytaax44_nvram,
+	.input_r            = sonytaax44_input_r,
+	.output_w           = sonytaax44_output_w,
+	.name               = "sonytaax44",
+	.state_size         = sizeof(t_sonytaax44_state)
+};
 
 void asp_process(t_asp_processor *asp, bool strobe, bool clock, bool bit)
 {
@@ -81,7 +97,7 @@ void asp_print_strobed(t_asp_processor *asp)
     {
         if (asp->strobed == true)
         {
-            printf("ASP data received %08X\n", asp->data);
+            vlog(LOG_ASP, LOG_INFO, "ASP data received %08X\n", asp->data);
             /* reset strobe state and zero the received data after usage */
             asp->strobed = false;
             asp->data = 0;
@@ -89,40 +105,21 @@ void asp_print_strobed(t_asp_processor *asp)
     }
 }
 
-void NVRAM_store(t_NVRAM *nvram, char* filename)
-{
-    FILE *f = NULL;
-    size_t retval;
-    f = fopen(filename, "wb");
-    if (f != NULL)
-    {
-        retval = fwrite(nvram->cells, sizeof(nvram->cells), 1, f);
-        if (retval != 1)
-        {
-            printf("ERROR: writing NVRAM to disk failed.");
-        }
-        fclose(f);
-    }
-}
+// only a machine that opened its store keeps the cells in a file
 
-void NVRAM_load(t_NVRAM *nvram, char* filename)
+void NVRAM_changed(ucom4cpu *cpu)
 {
-    FILE *f = NULL;
-    size_t retval;
-    f = fopen(filename, "rb");
-    if (f != NULL)
+    if (cpu->store != NULL)
     {
-        retval = fread(nvram->cells, sizeof(nvram->cells), 1, f);
-        if (retval != 1)
-        {
-            printf("ERROR: reading NVRAM from disk failed.");
-        }
-        fclose(f);
+        nvstore_touch(cpu->store);
     }
 }
 
-void NVRAM_process(t_NVRAM *nvram, uint8_t clock, uint8_t data_in, uint8_t *data_out)
+void NVRAM_process(ucom4cpu *cpu, uint8_t clock, uint8_t data_in, bool read)
 {
+    t_NVRAM *nvram = &TAAX44(cpu)->NVRAM;
+    uint16_t value;
+
     if ((nvram->mode != NVRAM_SB) && (clock != 0xFF))
     {
         /* Process the clock signal if not in standby mode and clock signal available */
@@ -143,10 +140,10 @@ void NVRAM_process(t_NVRAM *nvram, uint8_t clock, uint8_t data_in, uint8_t *data
         case NVRAM_RTNS :
             /* Information of the data register relayed by the
              * READ operation are put out from the D I/O terminal */
-            if ((data_out != NULL) && (nvram->clock_data == true))
+            if ((read == true) && (nvram->clock_data == true))
             {
 
-                *data_out = nvram->data & 0x01; /* write the data out */
+                nvram->data_out = nvram->data & 0x01; /* write the data out */
                 nvram->data >>= 1;              /* shift the data for next round */
                 nvram->clock_data = false;      /* acknowledge clock cycle */
             }
@@ -166,28 +163,36 @@ void NVRAM_process(t_NVRAM *nvram, uint8_t clock, uint8_t data_in, uint8_t *data
             /* Memorize the informations relayed by the WTNS operation
              * in the designated address
              */
-            printf("write %d \n", nvram->data);
-            nvram->cells[nvram->address] = 0;
-
+            value = 0;
             for (int i = 0; i < 16; i++)
             {
-                nvram->cells[nvram->address] |= ((nvram->data >> i) & 0x01) << (15-i);
+                value |= ((nvram->data >> i) & 0x01) << (15-i);
             }
 
-            NVRAM_store(nvram, "NVRAM.bin");
+            /* the mode stays WRT for many steps, only a change is news */
+            if (nvram->cells[nvram->address] != value)
+            {
+                vlog(LOG_NVRAM, LOG_INFO, "write %d \n", nvram->data);
+                nvram->cells[nvram->address] = value;
+                NVRAM_changed(cpu);
+            }
             break;
         case NVRAM_ERS  :
             /* Clears the information memorized in the designated
              * address
              */
-            nvram->cells[nvram->address] = 0x00;
+            if (nvram->cells[nvram->address] != 0x00)
+            {
+                nvram->cells[nvram->address] = 0x00;
+                NVRAM_changed(cpu);
+            }
             break;
         case NVRAM_READ :
             /* Relay the memorized informations in the designated
              * address to the data register
              */
             nvram->data = nvram->cells[nvram->address];
-            printf("read %d \n", nvram->data);
+            vlog(LOG_NVRAM, LOG_INFO, "read %d \n", nvram->data);
             break;
         case NVRAM_MSTNS:
             /* The control signals which follow the MSTNS operation are
@@ -220,11 +225,11 @@ void NVRAM_MODE_process(t_NVRAM *nvram, uint8_t mode)
     {
         if (mode != nvram->mode)
         {
-            if (mode < sizeof(mode_names))
+            if (mode < sizeof(mode_names) / sizeof(mode_names[0]))
             {
                 mode_name = mode_names[mode];
             }
-            printf("NVRAM MODE %d (%s)\n", mode, mode_name);
+            vlog(LOG_NVRAM, LOG_INFO, "NVRAM MODE %d (%s)\n", mode, VLOG_PTR(mode_name));
             nvram->mode = mode;
         }
     }
@@ -236,230 +241,68 @@ void NVRAM_ADDR_process(t_NVRAM *nvram, uint8_t address)
     {
         //if (address != nvram->address)
         {
-            printf("NVRAM ADDR %d\n", address);
+            vlog(LOG_NVRAM, LOG_INFO, "NVRAM ADDR %d\n", address);
             nvram->address = address;
         }
     }
 }
 
-void sonytaax44_close_gfx(void) {
-	int x,y;
-
-	for(x=0;x<15;x++) {
-		for(y=0;y<10;y++) {
-			if(gfx[x][y]) {
-				SDL_FreeSurface(gfx[x][y]);
-				gfx[x][y]=NULL;
-			}
-		}
-	}
-	SDL_FreeSurface(bg);
-	SDL_FreeSurface(bezel);
-	SDL_FreeSurface(vfd_display);
-	SDL_FreeSurface(tmpscreen);
-}
-
-#define BEZEL 0
-
-#define VOLUME_BAR_SIZE_X       (10)
-#define VOLUME_BAR_SIZE_Y       (40)
+/* Periph bus devices: port writes only log pin changes, the chips catch
+ * up when the cpu reads from them or the log fills up */
 
-void sonytaax44_load_volume_bar(uint8_t index, uint8_t x, uint8_t y)
+void asp_pins(void *device, uint16_t old, uint16_t pins)
 {
-    gfx_x[y][x] = 20 + (index * VOLUME_BAR_SIZE_X) + (index * 10);
-    gfx_y[y][x] = 100;
-    gfx[y][x] = IMG_Load("res/gfx/sonytaax44/VOLUME_BAR.png");
-}
+    t_asp_processor *asp = device;
 
-void sonytaax44_load_generic(char *filename, uint8_t x, uint8_t y, uint16_t posx, uint16_t posy)
-{
-    gfx_x[y][x] = posx;
-    gfx_y[y][x] = posy;
-    gfx[y][x] = IMG_Load(filename);
+    asp_process(asp, (bool)(pins & 0x01), (bool)((pins >> 2) & 0x01), (bool)((pins >> 1) & 0x01));
+    asp_print_strobed(asp);
 }
 
-void sonytaax44_setup_gfx(void) {
-	int x = 0;
-	int y = 0;
-	char filename[255];
-	
-	/* Load the content of the NVRAM */
-	NVRAM_load(&NVRAM, "NVRAM.bin");
-
-	IMG_Init(IMG_INIT_PNG);
-	SDL_Rect rect;
-	memset(gfx_x,0,sizeof(gfx_x));
-	memset(gfx_y,0,sizeof(gfx_y));
-
-//	bg=IMG_Load("res/gfx/astrowars/bg3.png");
-
-//	bezel=IMG_Load("res/gfx/astrowars/bezel.png");
-
-//	if(BEZEL)
-//		tmpscreen=IMG_Load("res/gfx/astrowars/bezel.png");
-//	else
-//		tmpscreen = bg;
-
-//	screen = SDL_SetVideoMode(tmpscreen->w,tmpscreen->h,32,SDL_HWSURFACE);
-	tmpscreen = screen = SDL_SetVideoMode(800,450,32,SDL_HWSURFACE);
-
-	vfd_display = screen;
-
-	//vfd_display=IMG_Load("res/gfx/astrowars/bg3.png");
-
-	sonytaax44_load_volume_bar(0, 1, TAAX44_GRID_C);
-    sonytaax44_load_volume_bar(1, 2, TAAX44_GRID_C);
-    sonytaax44_load_volume_bar(2, 3, TAAX44_GRID_C);
-    sonytaax44_load_volume_bar(3, 4, TAAX44_GRID_C);
+void NVRAM_pins(void *device, uint16_t old, uint16_t pins)
+{
+    ucom4cpu *cpu = device;
+    t_NVRAM *nvram = &TAAX44(cpu)->NVRAM;
 
-    sonytaax44_load_volume_bar(4, 5, TAAX44_GRID_C);
-    sonytaax44_load_volume_bar(5, 6, TAAX44_GRID_C);
-    sonytaax44_load_volume_bar(6, 7, TAAX44_GRID_C);
+    if ((pins ^ old) & NVRAM_PIN_ADDR)
+    {
+        NVRAM_ADDR_process(nvram, (pins & NVRAM_PIN_ADDR) >> 8);
+    }
+    if ((pins ^ old) & NVRAM_PIN_MODE)
+    {
+        NVRAM_MODE_process(nvram, (pins & NVRAM_PIN_MODE) >> 4);
+    }
+    /* the chip acts on every port E write, as it did when driven directly */
+    if ((pins ^ old) & NVRAM_PIN_WRITE)
+    {
+        NVRAM_process(cpu, (pins & NVRAM_PIN_CLOCK) ? 1 : 0, (pins & NVRAM_PIN_DATA) ? 1 : 0, false);
+    }
+}
 
-    // WRONG START
-    sonytaax44_load_volume_bar(7, 8, TAAX44_GRID_D + 2);
-    sonytaax44_load_volume_bar(8, 9, TAAX44_GRID_D + 2);
-    // WRONG END
-    sonytaax44_load_volume_bar(9, 7, TAAX44_GRID_D);
-    sonytaax44_load_volume_bar(10, 6, TAAX44_GRID_D);
-    sonytaax44_load_volume_bar(11, 5, TAAX44_GRID_D);
-    sonytaax44_load_volume_bar(12, 4, TAAX44_GRID_D);
+const periph_type asp_type   = { "ASP",   asp_pins };
+const periph_type NVRAM_type = { "NVRAM", NVRAM_pins };
 
-    sonytaax44_load_volume_bar(13, 3, TAAX44_GRID_D);
-    sonytaax44_load_volume_bar(14, 2, TAAX44_GRID_D);
-    sonytaax44_load_volume_bar(15, 1, TAAX44_GRID_D);
-    sonytaax44_load_volume_bar(16, 0, TAAX44_GRID_D);
 
-    sonytaax44_load_generic("res/gfx/sonytaax44/VOLUME.png", 0, TAAX44_GRID_C, 20, 25);
-    sonytaax44_load_generic("res/gfx/sonytaax44/BALANCE.png", 10, TAAX44_GRID_F, 20, 50);
-    sonytaax44_load_generic("res/gfx/sonytaax44/MUTING.png", 10, TAAX44_GRID_A, 325, 20);
+/* Load the content of the NVRAM, changes are written behind */
+void sonytaax44_open_store(ucom4cpu *cpu) {
+	cpu->store = calloc(1, sizeof(nvstore));
+	if (cpu->store != NULL)
+		nvstore_open(cpu->store, "NVRAM.bin", TAAX44(cpu)->NVRAM.cells, sizeof(TAAX44(cpu)->NVRAM.cells), NVSTORE_DEBOUNCE_MS, 1);
+}
 
-	// GRID 0
-	// VOLUME BARS
-	for (x = 0; x < 17; x++)
+/* last write of pending NVRAM changes */
+void sonytaax44_close_store(ucom4cpu *cpu) {
+	if (cpu->store != NULL)
 	{
-	    // Prepare positions
-//	    gfx_x[VOLUME_BAR_GRID][x] = 20 + (x * VOLUME_BAR_SIZE_X) + (x * 10);
-//	    gfx_y[VOLUME_BAR_GRID][x] = 10;
-//
-//	    // Repeat for testing
-//        gfx_x[VOLUME_BAR_GRID+1][x] = 20 + (x * VOLUME_BAR_SIZE_X) + (x * 10);
-//        gfx_y[VOLUME_BAR_GRID+1][x] = 10;
-//        gfx_x[VOLUME_BAR_GRID+2][x] = 20 + (x * VOLUME_BAR_SIZE_X) + (x * 10);
-//        gfx_y[VOLUME_BAR_GRID+2][x] = 10;
-//        gfx_x[VOLUME_BAR_GRID+3][x] = 20 + (x * VOLUME_BAR_SIZE_X) + (x * 10);
-//        gfx_y[VOLUME_BAR_GRID+3][x] = 10;
-//
-//	    // Load the GFX resource
-//	    sprintf(filename,"res/gfx/sonytaax44/%d-%d.png", VOLUME_BAR_GRID, (x+1));
-//	    gfx[VOLUME_BAR_GRID][x] = IMG_Load(filename);
-//        gfx[VOLUME_BAR_GRID+1][x] = IMG_Load(filename);
-//        gfx[VOLUME_BAR_GRID+2][x] = IMG_Load(filename);
-//        gfx[VOLUME_BAR_GRID+3][x] = IMG_Load(filename);
-
-//        if(gfx[VOLUME_BAR_GRID][x] != NULL)
-//        {
-//            rect.x=gfx_x[VOLUME_BAR_GRID][x];
-//            rect.y=gfx_y[VOLUME_BAR_GRID][x];
-//            rect.w=gfx[VOLUME_BAR_GRID][x]->w;
-//            rect.h=gfx[VOLUME_BAR_GRID][x]->h;
-//            SDL_BlitSurface(gfx[VOLUME_BAR_GRID][x], NULL, screen, &rect);
-//
-//            rect.x=gfx_x[VOLUME_BAR_GRID+1][x];
-//            rect.y=gfx_y[VOLUME_BAR_GRID+1][x];
-//            rect.w=gfx[VOLUME_BAR_GRID+1][x]->w;
-//            rect.h=gfx[VOLUME_BAR_GRID+1][x]->h;
-//            SDL_BlitSurface(gfx[VOLUME_BAR_GRID+1][x], NULL, screen, &rect);
-//
-//            rect.x=gfx_x[VOLUME_BAR_GRID+2][x];
-//            rect.y=gfx_y[VOLUME_BAR_GRID+2][x];
-//            rect.w=gfx[VOLUME_BAR_GRID+2][x]->w;
-//            rect.h=gfx[VOLUME_BAR_GRID+2][x]->h;
-//            SDL_BlitSurface(gfx[VOLUME_BAR_GRID+2][x], NULL, screen, &rect);
-//
-//            rect.x=gfx_x[VOLUME_BAR_GRID+3][x];
-//            rect.y=gfx_y[VOLUME_BAR_GRID+3][x];
-//            rect.w=gfx[VOLUME_BAR_GRID+3][x]->w;
-//            rect.h=gfx[VOLUME_BAR_GRID+3][x]->h;
-//            SDL_BlitSurface(gfx[VOLUME_BAR_GRID+3][x], NULL, screen, &rect);
-//        }
+		nvstore_close(cpu->store);
+		free(cpu->store);
+		cpu->store = NULL;
 	}
-
-
-    
-//	for(x=0;x<15;x++)
-//	{
-//		for(y=0;y<10;y++)
-//		{
-//			sprintf(filename,"res/gfx/astrowars/%d.%d.png", y, x);
-//
-//			gfx[y][x]=IMG_Load(filename);
-//
-//			if(gfx[y][x]) {
-//				rect.x=gfx_x[y][x];
-//				rect.y=gfx_y[y][x];
-//				rect.w=gfx[y][x]->w;
-//				rect.h=gfx[y][x]->h;
-//				SDL_BlitSurface(gfx[y][x],NULL, vfd_display,&rect);
-//			}
-//		}
-//	}
-	
-	//SDL_BlitSurface(vfd_display, NULL, screen, NULL);
-
-	SDL_Flip(screen);
 }
 
-void sonytaax44_display_update(void) {
-	int x,y;
-	SDL_Rect rect;
-	SDL_Surface *tmp;
-
-	SDL_FillRect(tmpscreen, NULL, SDL_MapRGB(tmpscreen->format, 0,0,0));
-
-	SDL_FillRect(vfd_display, NULL, SDL_MapRGB(vfd_display->format, 0,0,0));
-
-	for(x=0;x<12;x++) {
-		for(y=0;y<6;y++)
-		{
-			if(gfx[y][x] && (active_game->cpu->display_cache[y]&1<<x))
-			{
-				rect.x=gfx_x[y][x];
-				rect.y=gfx_y[y][x];
-				rect.w=gfx[y][x]->w;
-				rect.h=gfx[y][x]->h;
-				SDL_BlitSurface(gfx[y][x],NULL, vfd_display,&rect);
-			}
-		}
-	}
-
-//	SDL_UnlockSurface( vfd_display );
-
-//	SDL_LockSurface( screen );
-
-if(BEZEL) {
-	rect.x=192;
-	rect.y=84;
-	rect.w=274-182;
-	rect.h=362-84;
-
-	tmp = rotozoomSurface(vfd_display, 0, .35,1);//rect.w/vfd_display->w,1);
-
-	SDL_BlitSurface(tmp, NULL, tmpscreen, &rect);
-
-	SDL_FreeSurface(tmp);
-
-	SDL_BlitSurface(bezel, NULL, tmpscreen, NULL);
-
-	SDL_BlitSurface(tmpscreen, NULL, screen, NULL);
-
-//	SDL_UnlockSurface( screen );
-	} else {
-		SDL_BlitSurface(vfd_display,NULL,screen,NULL);
-	}
-	SDL_Flip(screen);
-	SDL_PauseAudio(0);
-
+/* NVRAM cells of cpu's machine */
+void *sonytaax44_nvram(ucom4cpu *cpu, int *size) {
+	*size = sizeof(TAAX44(cpu)->NVRAM.cells);
+	return TAAX44(cpu)->NVRAM.cells;
 }
 
 void sonytaax44_prepare_display(ucom4cpu *cpu) {
@@ -534,7 +377,7 @@ void sonytaax44_output_w(ucom4cpu *cpu, int index, uint8_t data)
 
 			shift = (index - NEC_UCOM4_PORTC) * 4;
 			cpu->plate = (cpu->plate & ~(0xf << shift)) | (data << shift);
-			active_game->prepare_display(cpu);
+			cpu->game->prepare_display(cpu);
 			//printf("plate CD %d\n", cpu->plate);
 			break;
 		case NEC_UCOM4_PORTF:
@@ -559,7 +402,7 @@ void sonytaax44_output_w(ucom4cpu *cpu, int index, uint8_t data)
             cpu->grid = (cpu->grid & ~(0x1 << 4)) | (((data >> 3) & 0x1) << 4);
 
             /* Prepare the display view */
-            active_game->prepare_display(cpu);
+            cpu->game->prepare_display(cpu);
             //printf("F GRID %d\n", cpu->grid);
 		    break;
 		case NEC_UCOM4_PORTG:
@@ -581,35 +424,35 @@ void sonytaax44_output_w(ucom4cpu *cpu, int index, uint8_t data)
 
             //printf("G GRID %d\n", cpu->grid);
 
-            active_game->prepare_display(cpu);
+            cpu->game->prepare_display(cpu);
 
 		    break;
 		case NEC_UCOM4_PORTH:
 		    /* Address port, 3-bits */
-            NVRAM_ADDR_process(&NVRAM, data);
+            periph_write(&TAAX44(cpu)->nvram_bus, &NVRAM_type, cpu, NVRAM_PIN_ADDR, data << 8);
             break;
 		case NEC_UCOM4_PORTI:
 		    /* Mode decoder port, 3-bits */
-            NVRAM_MODE_process(&NVRAM, data & 0x7);
+            periph_write(&TAAX44(cpu)->nvram_bus, &NVRAM_type, cpu, NVRAM_PIN_MODE, (data & 0x7) << 4);
 			break;
 		case NEC_UCOM4_PORTE:
 		    if ((data >> 3) & 0x1)
 		    {
-		        static int relay_drive_act = 0;
 		        /* Relay Drive Active: do the initial interrupt */
-		        if (relay_drive_act != ((data >> 3) & 0x1))
+		        if (TAAX44(cpu)->relay_drive_act != ((data >> 3) & 0x1))
 		        {
-		            printf("Relay Drive Activated\n");
-		            relay_drive_act = ((data >> 3) & 0x1);
+		            vlog(LOG_DRIVER, LOG_INFO, "Relay Drive Activated\n");
+		            TAAX44(cpu)->relay_drive_act = ((data >> 3) & 0x1);
 		        }
 		    }
 
-            /* ASP clock pin; ASP data pin */
-            asp_process(&ASP, (bool)(data & 0x01), (bool)((data >> 2) & 0x01), (bool)((data >> 1) & 0x01));
-            asp_print_strobed(&ASP);
+            /* ASP strobe, data and clock pins */
+            periph_write(&TAAX44(cpu)->asp_bus, &asp_type, &TAAX44(cpu)->ASP, 0x7, data & 0x7);
 
             /* NVRAM (when not in standby): gets data input from MCU */
-            NVRAM_process(&NVRAM, (uint8_t)((data >> 2) & 0x01), (uint8_t)((data >> 1) & 0x01), NULL);
+            periph_write(&TAAX44(cpu)->nvram_bus, &NVRAM_type, cpu,
+                         NVRAM_PIN_CLOCK | NVRAM_PIN_DATA | NVRAM_PIN_WRITE,
+                         ((data >> 2) & 0x01) | (data & 0x02) | (~TAAX44(cpu)->nvram_bus.pins & NVRAM_PIN_WRITE));
 
 		    break;
 		default:
@@ -624,7 +467,6 @@ uint8_t sonytaax44_input_r(ucom4cpu *cpu, int index)
 {
 	index &= 0xf;
 	uint8_t inp = 0;
-	uint8_t nvram_bit;
 
 	// try all "highs"
 	//inp = 0xF;
@@ -639,46 +481,47 @@ uint8_t sonytaax44_input_r(ucom4cpu *cpu, int index)
 
 		    inp = 0x0;      // mettendo a F cambia il comportamento della PORT-C
 		                    // e sul 024 incoinciano a muoversi ciclicamente diverse uscite
-		    //inp |= inputs[18];
-		    inp = inputs[18] << 1;
+		    //inp |= cpu->inputs[18];
+		    inp = cpu->inputs[18] << 1;
             /* NVRAM (when not in standby): produces data for the MCU */
-            NVRAM_process(&NVRAM, 255, 255, &nvram_bit);
-            inp |= nvram_bit << 2;
+            periph_sync(&TAAX44(cpu)->nvram_bus, &NVRAM_type, cpu);
+            NVRAM_process(cpu, 255, 255, true);
+            inp |= TAAX44(cpu)->NVRAM.data_out << 2;
 
 			break;
 		case NEC_UCOM4_PORTB:
 
 		    if ((cpu->grid >> TAAX44_GRID_B) & 0x01)
 		    {
-		        inp = inputs[2] << 1;               /* Volume Up;...;... matrix */
-                inp |= inputs[1] & 0x01;            /* Volume Dw;...;... matrix */
-                inp |= inputs[5] << 2;              /* MUTING */
+		        inp = cpu->inputs[2] << 1;               /* Volume Up;...;... matrix */
+                inp |= cpu->inputs[1] & 0x01;            /* Volume Dw;...;... matrix */
+                inp |= cpu->inputs[5] << 2;              /* MUTING */
 		    }
 		    else if ((cpu->grid >> TAAX44_GRID_C) & 0x01)
 		    {
-                inp  = inputs[16] << 0;             /* subsonic filter */
-                inp |= inputs[17] << 1;             /* high filter */
-                inp |= inputs[3] << 2;              /* Balance R;...;... matrix */
-                inp |= inputs[4] << 3;              /* Balance L;...;... matrix */
+                inp  = cpu->inputs[16] << 0;             /* subsonic filter */
+                inp |= cpu->inputs[17] << 1;             /* high filter */
+                inp |= cpu->inputs[3] << 2;              /* Balance R;...;... matrix */
+                inp |= cpu->inputs[4] << 3;              /* Balance L;...;... matrix */
 		    }
 		    else if ((cpu->grid >> TAAX44_GRID_A) & 0x01)
 		    {
-                inp  = inputs[9] << 0;              /* TAPE 1 */
-                inp |= inputs[10] << 1;              /* TAPE 2 */
-                inp |= inputs[11] << 2;              /*  TAPE 1-2 COPY */
+                inp  = cpu->inputs[9] << 0;              /* TAPE 1 */
+                inp |= cpu->inputs[10] << 1;              /* TAPE 2 */
+                inp |= cpu->inputs[11] << 2;              /*  TAPE 1-2 COPY */
 		    }
 		    else if ((cpu->grid >> TAAX44_GRID_E) & 0x01)
 		    {
-                inp  = inputs[6] << 0;              /* TUNER */
-                inp |= inputs[7] << 1;              /* TUNER */
-                inp |= inputs[8] << 2;              /* DAD/AUX */
+                inp  = cpu->inputs[6] << 0;              /* TUNER */
+                inp |= cpu->inputs[7] << 1;              /* TUNER */
+                inp |= cpu->inputs[8] << 2;              /* DAD/AUX */
 		    }
             else if ((cpu->grid >> TAAX44_GRID_D) & 0x01)
             {
-                inp  = inputs[12] << 0;              /* bass - */
-                inp |= inputs[13] << 1;              /* bass + */
-                inp |= inputs[14] << 2;              /* treble - */
-                inp |= inputs[15] << 3;              /* treble + */
+                inp  = cpu->inputs[12] << 0;              /* bass - */
+                inp |= cpu->inputs[13] << 1;              /* bass + */
+                inp |= cpu->inputs[14] << 2;              /* treble - */
+                inp |= cpu->inputs[15] << 3;              /* treble + */
             }
 
 			break;
@@ -5,8 +5,11 @@
 extern vfd_game game_sonytaax44;
 
 void sonytaax44_prepare_display(ucom4cpu *cpu);
-void sonytaax44_setup_gfx(void);
-void sonytaax44_display_update(void);
+void sonytaax44_setup_gfx(struct _vfd_render *r);
+void sonytaax44_display_update(struct _vfd_render *r);
 void sonytaax44_output_w(ucom4cpu *cpu, int index, uint8_t data);
 uint8_t sonytaax44_input_r(ucom4cpu *cpu, int index);
-void sonytaax44_close_gfx(void);
+void sonytaax44_close_gfx(struct _vfd_render *r);
+void sonytaax44_open_store(ucom4cpu *cpu);
+void sonytaax44_close_store(ucom4cpu *cpu);
+void *sonytaax44_nvram(ucom4cpu *cpu, int *size);
@@ -0,0 +1,49 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * sonytaax44_gfx.c
+ *
+ * Drawing half of the sonytaax44 driver.
+ *
+ *************************/
+#include <SDL.h>
+#include <SDL_image.h>
+#include "driver.h"
+#include "sonytaax44.h"
+#include "render.h"
+
+vfd_gfx gfx_sonytaax44 = {
+	.game               = &game_sonytaax44,
+	.setup_gfx          = sonytaax44_setup_gfx,
+	.close_gfx          = sonytaax44_close_gfx,
+	.display_update     = sonytaax44_display_update
+};
+
+void sonytaax44_close_gfx(vfd_render *r) {
+	segload_close(&r->segs);
+	layout_close(&r->layout);
+}
+
+void sonytaax44_setup_gfx(vfd_render *r) {
+	IMG_Init(IMG_INIT_PNG);
+
+	// volume bars, volume, balance and muting; one bar image is shared
+	// by all 17 bar segments
+	if (layout_open(&r->layout, r->game->layout) < 0)
+		return;
+	segload_open(&r->segs, "res/gfx/sonytaax44/", &r->layout);
+
+	r->w = 800;
+	r->h = 450;
+}
+
+void sonytaax44_display_update(vfd_render *r) {
+	SDL_FillRect(r->out, NULL, SDL_MapRGB(r->out->format, 0,0,0));
+
+	segload_draw(&r->segs, r->cpu->display_cache, r->out);
+}
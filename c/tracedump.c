@@ -0,0 +1,75 @@
+/************************
+ *
+ * UCOM4 TRACE DECODER
+ *
+ * (c) 2016 MikeDX
+ *
+ * tracedump <file> [first [count]]
+ *
+ *************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ucom4_trace.h"
+#include "ucom4_dasm.h"
+
+#define BLOCK 4096
+
+int main(int argc, char *argv[])
+{
+	ucom4_trace_header header;
+	ucom4_trace_rec recs[BLOCK], *rec;
+	unsigned long long index = 0, cycles = 0, first = 0, count = ~0ULL;
+	size_t n, x;
+	char dasm[32];
+	FILE *f;
+
+	if(argc < 2) {
+		fprintf(stderr, "usage: tracedump <file> [first [count]]\n");
+		return -1;
+	}
+
+	if(argc > 2)
+		first = strtoull(argv[2], NULL, 0);
+	if(argc > 3)
+		count = strtoull(argv[3], NULL, 0);
+
+	f = fopen(argv[1], "rb");
+	if(!f) {
+		fprintf(stderr, "Cannot open trace %s\n", argv[1]);
+		return -1;
+	}
+
+	if(fread(&header, sizeof(header), 1, f) != 1 || header.magic != UCOM4_TRACE_MAGIC ||
+	   header.version != UCOM4_TRACE_VERSION || header.rec_size != sizeof(ucom4_trace_rec)) {
+		fprintf(stderr, "Not a trace file, or a different version\n");
+		fclose(f);
+		return -1;
+	}
+
+	printf("     index     cycle  PC  OP AR  code          ACC DP  C CS SK INT INTE TMR\n");
+
+	while(count && (n = fread(recs, sizeof(ucom4_trace_rec), BLOCK, f)) > 0) {
+		for(x = 0; x < n && count; x++, index++) {
+			rec = &recs[x];
+			cycles += rec->cycles;
+
+			if(index < first)
+				continue;
+			count--;
+
+			ucom4_disasm_op(dasm, rec->pc, rec->op, rec->arg);
+			printf("%10llu %9llu  %03X %02X %02X  %-12s  %X   %02X  %d  %d  %d  %d   %d    %d%s\n",
+				index, cycles, rec->pc, rec->op, rec->arg, dasm, rec->acc, rec->dp,
+				!!(rec->flags & UCOM4_TRACE_CARRY), !!(rec->flags & UCOM4_TRACE_CARRY_S),
+				!!(rec->flags & UCOM4_TRACE_SKIP), !!(rec->flags & UCOM4_TRACE_INT),
+				!!(rec->flags & UCOM4_TRACE_INTE), !!(rec->flags & UCOM4_TRACE_TIMER),
+				(rec->flags & UCOM4_TRACE_SKIPPED) ? "  (skipped)" : "");
+		}
+	}
+
+	fclose(f);
+
+	return 0;
+}
@@ -0,0 +1,259 @@
+/************************
+ *
+ * UCOM4 CONTROL FLOW ANALYSER
+ *
+ * (c) 2016 MikeDX
+ *
+ *************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "ucom4_cfg.h"
+#include "ucom4_dasm.h"
+
+#define NEXT(pc)    UCOM4_NEXT_PC(pc)
+
+// address following the instruction at pc
+static uint16_t after(const uint8_t *rom, uint16_t pc)
+{
+	return ucom4_ops[rom[pc]].bytes == 2 ? NEXT(NEXT(pc)) : NEXT(pc);
+}
+
+// Static successors of the instruction at pc. A call returns to the
+// next instruction, so that is its only successor; the target goes
+// to *call. Returns are left without successors.
+
+static int successors(const uint8_t *rom, uint16_t pc, uint16_t *succ, int *call)
+{
+	uint8_t op = rom[pc];
+	uint16_t next = after(rom, pc);
+	int n = 0, x;
+
+	*call = -1;
+
+	switch (ucom4_ops[op].flow)
+	{
+		case UCOM4_FLOW_NEXT:
+			succ[n++] = next;
+			break;
+
+		case UCOM4_FLOW_SKIP:
+			succ[n++] = next;
+			succ[n++] = after(rom, next);
+			break;
+
+		case UCOM4_FLOW_JUMP:
+			succ[n++] = ucom4_branch_target(pc, op, rom[NEXT(pc)]);
+			break;
+
+		case UCOM4_FLOW_CALL:
+			*call = ucom4_branch_target(pc, op, rom[NEXT(pc)]);
+			succ[n++] = next;
+			break;
+
+		case UCOM4_FLOW_TABLE:
+			// ACC is unknown here, so every 4 byte slot in the page is a target
+			for (x = 0; x < 16; x++)
+				succ[n++] = (NEXT(pc) & ~0x3f) | (x << 2);
+			break;
+
+		default:
+			break;
+	}
+
+	return n;
+}
+
+static void mark_leader(ucom4_cfg *cfg, uint16_t *work, int *nwork, uint16_t pc)
+{
+	if (!(cfg->flags[pc] & UCOM4_CFG_LEADER))
+	{
+		cfg->flags[pc] |= UCOM4_CFG_LEADER;
+		work[(*nwork)++] = pc;
+	}
+}
+
+// Recursive descent from reset and the interrupt vector. The first
+// pass marks code and leaders, the second cuts the blocks.
+
+void ucom4_cfg_analyse(ucom4_cfg *cfg, const uint8_t *rom)
+{
+	uint16_t work[UCOM4_CFG_ROM];
+	uint16_t succ[UCOM4_CFG_MAX_SUCC];
+	int nwork = 0, nsucc, call, x;
+	uint16_t pc, start;
+	ucom4_block *b;
+	uint8_t flow;
+
+	memset(cfg, 0, sizeof(*cfg));
+	memset(cfg->block_at, 0xff, sizeof(cfg->block_at));
+
+	mark_leader(cfg, work, &nwork, UCOM4_CFG_RESET);
+	mark_leader(cfg, work, &nwork, UCOM4_CFG_VECTOR);
+	cfg->flags[UCOM4_CFG_RESET] |= UCOM4_CFG_SUB;
+	cfg->flags[UCOM4_CFG_VECTOR] |= UCOM4_CFG_SUB;
+
+	while (nwork)
+	{
+		pc = work[--nwork];
+
+		// follow the straight line code until it leaves or meets known code
+		while (!(cfg->flags[pc] & UCOM4_CFG_CODE))
+		{
+			cfg->flags[pc] |= UCOM4_CFG_CODE;
+			if (ucom4_ops[rom[pc]].bytes == 2)
+				cfg->flags[NEXT(pc)] |= UCOM4_CFG_OPERAND;
+			cfg->insns++;
+
+			flow = ucom4_ops[rom[pc]].flow;
+			nsucc = successors(rom, pc, succ, &call);
+
+			if (call >= 0)
+			{
+				cfg->flags[call] |= UCOM4_CFG_SUB;
+				mark_leader(cfg, work, &nwork, call);
+			}
+
+			if (flow == UCOM4_FLOW_NEXT)
+			{
+				pc = succ[0];
+				continue;
+			}
+
+			if (flow == UCOM4_FLOW_TABLE)
+			{
+				cfg->tables++;
+				for (x = 0; x < nsucc; x++)
+					cfg->flags[succ[x]] |= UCOM4_CFG_TABLE;
+			}
+
+			for (x = 0; x < nsucc; x++)
+				mark_leader(cfg, work, &nwork, succ[x]);
+			break;
+		}
+	}
+
+	for (pc = 0; pc < UCOM4_CFG_ROM; pc++)
+	{
+		if ((cfg->flags[pc] & (UCOM4_CFG_CODE | UCOM4_CFG_OPERAND)) == (UCOM4_CFG_CODE | UCOM4_CFG_OPERAND))
+		{
+			cfg->flags[pc] |= UCOM4_CFG_OVERLAP;
+			cfg->overlaps++;
+		}
+		if (cfg->flags[pc] & UCOM4_CFG_SUB)
+			cfg->subs++;
+	}
+
+	// cut blocks at leaders and at every instruction that does not just fall through
+	for (start = 0; start < UCOM4_CFG_ROM; start++)
+	{
+		if (!(cfg->flags[start] & UCOM4_CFG_LEADER))
+			continue;
+
+		b = &cfg->blocks[cfg->nblocks];
+		cfg->block_at[start] = cfg->nblocks++;
+		b->start = start;
+		pc = start;
+
+		for (;;)
+		{
+			b->insns++;
+			b->last = pc;
+			b->flow = ucom4_ops[rom[pc]].flow;
+			b->nsucc = successors(rom, pc, b->succ, &call);
+			b->call = call;
+
+			if (b->flow != UCOM4_FLOW_NEXT || (cfg->flags[b->succ[0]] & UCOM4_CFG_LEADER))
+				break;
+			pc = b->succ[0];
+		}
+	}
+}
+
+static const char *flow_name[] = { "fall", "skip", "jump", "call", "ret", "rets", "table" };
+
+static void list_block(ucom4_block *b, const uint8_t *rom, FILE *f, const char *eol)
+{
+	char dasm[32];
+	uint16_t pc = b->start;
+	int x, len;
+
+	for (x = 0; x < b->insns; x++)
+	{
+		len = ucom4_disasm(dasm, pc, rom);
+		if (len == 2)
+			fprintf(f, "  %03X  %02X %02X  %s%s", pc, rom[pc], rom[NEXT(pc)], dasm, eol);
+		else
+			fprintf(f, "  %03X  %02X     %s%s", pc, rom[pc], dasm, eol);
+		pc = after(rom, pc);
+	}
+}
+
+// plain listing, one block after the other in address order
+
+void ucom4_cfg_list(ucom4_cfg *cfg, const uint8_t *rom, FILE *f)
+{
+	ucom4_block *b;
+	int x, y;
+
+	for (x = 0; x < cfg->nblocks; x++)
+	{
+		b = &cfg->blocks[x];
+
+		fprintf(f, "\n");
+		if (b->start == UCOM4_CFG_RESET)
+			fprintf(f, "; reset\n");
+		else if (b->start == UCOM4_CFG_VECTOR)
+			fprintf(f, "; interrupt\n");
+		else if (cfg->flags[b->start] & UCOM4_CFG_SUB)
+			fprintf(f, "; subroutine\n");
+		if (cfg->flags[b->start] & UCOM4_CFG_TABLE)
+			fprintf(f, "; jump table entry\n");
+		if (cfg->flags[b->start] & UCOM4_CFG_OVERLAP)
+			fprintf(f, "; overlaps an operand\n");
+
+		fprintf(f, "L%03X:\n", b->start);
+		list_block(b, rom, f, "\n");
+
+		fprintf(f, "        ; %s", flow_name[b->flow]);
+		if (b->call >= 0)
+			fprintf(f, " L%03X", b->call);
+		if (b->nsucc)
+			fprintf(f, " ->");
+		for (y = 0; y < b->nsucc; y++)
+			fprintf(f, " L%03X", b->succ[y]);
+		fprintf(f, "\n");
+	}
+
+	fprintf(f, "\n; %d instructions, %d blocks, %d subroutines, %d jump tables, %d overlaps\n",
+		cfg->insns, cfg->nblocks, cfg->subs, cfg->tables, cfg->overlaps);
+}
+
+// graphviz output, calls are dashed and jump table edges dotted
+
+void ucom4_cfg_dot(ucom4_cfg *cfg, const uint8_t *rom, FILE *f)
+{
+	ucom4_block *b;
+	int x, y;
+
+	fprintf(f, "digraph ucom4 {\n");
+	fprintf(f, "\tnode [shape=box fontname=monospace];\n");
+
+	for (x = 0; x < cfg->nblocks; x++)
+	{
+		b = &cfg->blocks[x];
+
+		fprintf(f, "\tL%03X [label=\"L%03X:\\l", b->start, b->start);
+		list_block(b, rom, f, "\\l");
+		fprintf(f, "\"%s];\n", (cfg->flags[b->start] & UCOM4_CFG_SUB) ? " penwidth=2" : "");
+
+		if (b->call >= 0)
+			fprintf(f, "\tL%03X -> L%03X [style=dashed];\n", b->start, b->call);
+		for (y = 0; y < b->nsucc; y++)
+			fprintf(f, "\tL%03X -> L%03X%s;\n", b->start, b->succ[y],
+				b->flow == UCOM4_FLOW_TABLE ? " [style=dotted]" : "");
+	}
+
+	fprintf(f, "}\n");
+}
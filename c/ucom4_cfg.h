@@ -0,0 +1,56 @@
+/************************
+ *
+ * UCOM4 CONTROL FLOW ANALYSER
+ *
+ * (c) 2016 MikeDX
+ *
+ * Walks the ROM from reset and the interrupt vector and splits
+ * the reachable code into basic blocks.
+ *
+ *************************/
+
+#ifndef _UCOM4_CFG_H_
+#define _UCOM4_CFG_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define UCOM4_CFG_ROM       0x800
+#define UCOM4_CFG_RESET     0x000
+#define UCOM4_CFG_VECTOR    0x03c
+#define UCOM4_CFG_MAX_SUCC  16
+
+// per address flags
+#define UCOM4_CFG_CODE      0x01    // first byte of an instruction
+#define UCOM4_CFG_OPERAND   0x02    // second byte of an instruction
+#define UCOM4_CFG_LEADER    0x04    // starts a basic block
+#define UCOM4_CFG_SUB       0x08    // reset, interrupt or call target
+#define UCOM4_CFG_TABLE     0x10    // JPA table entry
+#define UCOM4_CFG_OVERLAP   0x20    // decoded both as code and operand
+
+typedef struct _ucom4_block {
+	uint16_t start;
+	uint16_t last;                      // address of the last instruction
+	uint16_t insns;
+	uint8_t flow;                       // UCOM4_FLOW_* of the last instruction
+	uint8_t nsucc;
+	uint16_t succ[UCOM4_CFG_MAX_SUCC];
+	int16_t call;                       // call target, -1 if none
+} ucom4_block;
+
+typedef struct _ucom4_cfg {
+	uint8_t flags[UCOM4_CFG_ROM];
+	int16_t block_at[UCOM4_CFG_ROM];    // block index by start address, -1 if none
+	ucom4_block blocks[UCOM4_CFG_ROM];
+	int nblocks;
+	int insns;
+	int subs;
+	int tables;
+	int overlaps;
+} ucom4_cfg;
+
+void ucom4_cfg_analyse(ucom4_cfg *cfg, const uint8_t *rom);
+void ucom4_cfg_list(ucom4_cfg *cfg, const uint8_t *rom, FILE *f);
+void ucom4_cfg_dot(ucom4_cfg *cfg, const uint8_t *rom, FILE *f);
+
+#endif
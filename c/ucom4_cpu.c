@@ -11,6 +11,10 @@
  *************************/
 
 #include "driver.h"
+#include "ucom4_profile.h"
+#include "ucom4_trace.h"
+#include "ucom4_dasm.h"
+#include "vfdlog.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -19,10 +23,6 @@
 #define false 0
 #define true  1
 
-int audiosize = 10240;
-uint8_t audiobuf[10240];
-int aindex = 0;
-
 void push_stack(ucom4cpu *cpu);
 
 void ucom4_reset(ucom4cpu *cpu) {
@@ -36,6 +36,7 @@ void ucom4_reset(ucom4cpu *cpu) {
 	cpu->inte_f     = 0;
 	cpu->icount     = 0;
 	cpu->old_icount = 0;
+	cpu->overflow   = 0;
 	cpu->bitmask    = 0;
 	cpu->prgmask    = 0x7FF;
 	cpu->datamask   = 0x7F;
@@ -58,6 +59,7 @@ void ucom4_reset(ucom4cpu *cpu) {
 	cpu->display_wait = 33;
 	cpu->decay_ticks = 0;
 	cpu->totalticks = 0;
+	cpu->instructions = 0;
 	cpu->audio_avail = 0;
 }
 
@@ -82,7 +84,7 @@ void increment_pc(ucom4cpu *cpu)
 void fetch_arg(ucom4cpu *cpu)
 {
 	// 2-byte opcodes: STM/LDI/CLI/CI, JMP/CAL, OCD
-	if ((cpu->op & 0xfc) == 0x14 || (cpu->op & 0xf0) == 0xa0 || cpu->op == 0x1e)
+	if (ucom4_ops[cpu->op].bytes == 2)
 	{
 		cpu->icount--;
 		cpu->arg = cpu->rom[cpu->pc];
@@ -127,7 +129,7 @@ void ucom4_display_decay(ucom4cpu *cpu);
 
 void ucom4_display_update(ucom4cpu *cpu)
 {
-	uint32_t active_state[0x20];
+	uint32_t active_state[0x20] = { 0 };
 	uint32_t ds;
 	int decay_time = 80;
 
@@ -236,13 +238,11 @@ void ucom4_display_matrix(ucom4cpu *cpu, int maxx, int maxy, int setx, int sety)
 
 }
 
-FILE *sound_out = 0;
-
 // basic instruction set
 
 void op_illegal(ucom4cpu *cpu)
 {
-	printf("Unknown opcode $%02X at $%03X\n", cpu->op, cpu->prev_pc);
+	vlog(LOG_CPU, LOG_WARN, "Unknown opcode $%02X at $%03X\n", cpu->op, cpu->prev_pc);
 }
 
 
@@ -462,26 +462,26 @@ void op_reb(ucom4cpu *cpu)
 {
 	// REB B: Reset a single bit of output port E
 	cpu->icount--;
-	active_game->output_w(cpu, NEC_UCOM4_PORTE, cpu->port_out[NEC_UCOM4_PORTE] & ~cpu->bitmask);
+	cpu->game->output_w(cpu, NEC_UCOM4_PORTE, cpu->port_out[NEC_UCOM4_PORTE] & ~cpu->bitmask);
 }
 
 void op_seb(ucom4cpu *cpu)
 {
 	// SEB B: Set a single bit of output port E
 	cpu->icount--;
-	active_game->output_w(cpu, NEC_UCOM4_PORTE, cpu->port_out[NEC_UCOM4_PORTE] | cpu->bitmask);
+	cpu->game->output_w(cpu, NEC_UCOM4_PORTE, cpu->port_out[NEC_UCOM4_PORTE] | cpu->bitmask);
 }
 
 void op_rpb(ucom4cpu *cpu)
 {
 	// RPB B: Reset a single bit of output port (DPl)
-	active_game->output_w(cpu, cpu->dpl, cpu->port_out[cpu->dpl] & ~cpu->bitmask);
+	cpu->game->output_w(cpu, cpu->dpl, cpu->port_out[cpu->dpl] & ~cpu->bitmask);
 }
 
 void op_spb(ucom4cpu *cpu)
 {
 	// SPB B: Set a single bit of output port (DPl)
-	active_game->output_w(cpu, cpu->dpl, cpu->port_out[cpu->dpl] | cpu->bitmask);
+	cpu->game->output_w(cpu, cpu->dpl, cpu->port_out[cpu->dpl] | cpu->bitmask);
 }
 
 
@@ -538,7 +538,7 @@ void op_ci(ucom4cpu *cpu)
 	cpu->skip = (cpu->acc == (cpu->arg & 0x0f));
 
 	if ((cpu->arg & 0xf0) != 0xc0)
-		printf("CI opcode unexpected upper arg $%02X at $%03X\n", cpu->arg & 0xf0, cpu->prev_pc);
+		vlog(LOG_CPU, LOG_WARN, "CI opcode unexpected upper arg $%02X at $%03X\n", cpu->arg & 0xf0, cpu->prev_pc);
 }
 
 void op_cm(ucom4cpu *cpu)
@@ -565,7 +565,7 @@ void op_cli(ucom4cpu *cpu)
 	cpu->skip = (cpu->dpl == (cpu->arg & 0x0f));
 
 	if ((cpu->arg & 0xf0) != 0xe0)
-		printf("CLI opcode unexpected upper arg $%02X at $%03X\n", cpu->arg & 0xf0, cpu->prev_pc);
+		vlog(LOG_CPU, LOG_WARN, "CLI opcode unexpected upper arg $%02X at $%03X\n", cpu->arg & 0xf0, cpu->prev_pc);
 }
 
 void op_tmb(ucom4cpu *cpu)
@@ -577,13 +577,13 @@ void op_tmb(ucom4cpu *cpu)
 void op_tpa(ucom4cpu *cpu)
 {
 	// TPA B: skip next on bit(input port A)
-	cpu->skip = ((active_game->input_r(cpu, NEC_UCOM4_PORTA) & cpu->bitmask) != 0);
+	cpu->skip = ((cpu->game->input_r(cpu, NEC_UCOM4_PORTA) & cpu->bitmask) != 0);
 }
 
 void op_tpb(ucom4cpu *cpu)
 {
 	// TPB B: skip next on bit(input port (DPl))
-	cpu->skip = ((active_game->input_r(cpu, cpu->dpl) & cpu->bitmask) != 0);
+	cpu->skip = ((cpu->game->input_r(cpu, cpu->dpl) & cpu->bitmask) != 0);
 }
 
 
@@ -603,33 +603,33 @@ void op_ia(ucom4cpu *cpu)
 {
 	// IA: Input port A to ACC
 	cpu->icount--;
-	cpu->acc = active_game->input_r(cpu, NEC_UCOM4_PORTA);
+	cpu->acc = cpu->game->input_r(cpu, NEC_UCOM4_PORTA);
 }
 
 void op_ip(ucom4cpu *cpu)
 {
 	// IP: Input port (DPl) to ACC
-	cpu->acc = active_game->input_r(cpu, cpu->dpl);
+	cpu->acc = cpu->game->input_r(cpu, cpu->dpl);
 }
 
 void op_oe(ucom4cpu *cpu)
 {
 	// OE: Output ACC to port E
 	cpu->icount--;
-	active_game->output_w(cpu, NEC_UCOM4_PORTE, cpu->acc);
+	cpu->game->output_w(cpu, NEC_UCOM4_PORTE, cpu->acc);
 }
 
 void op_op(ucom4cpu *cpu)
 {
 	// OP: Output ACC to port (DPl)
-	active_game->output_w(cpu, cpu->dpl, cpu->acc);
+	cpu->game->output_w(cpu, cpu->dpl, cpu->acc);
 }
 
 void op_ocd(ucom4cpu *cpu)
 {
 	// OCD X: Output X to ports C and D
-	active_game->output_w(cpu, NEC_UCOM4_PORTD, cpu->arg >> 4);
-	active_game->output_w(cpu, NEC_UCOM4_PORTC, cpu->arg & 0xf);
+	cpu->game->output_w(cpu, NEC_UCOM4_PORTD, cpu->arg >> 4);
+	cpu->game->output_w(cpu, NEC_UCOM4_PORTC, cpu->arg & 0xf);
 }
 
 
@@ -638,6 +638,7 @@ void op_ocd(ucom4cpu *cpu)
 void op_nop(ucom4cpu *cpu)
 {
 	// NOP: No Operation
+	(void)cpu;
 }
 
 
@@ -648,7 +649,7 @@ uint8_t check_op_43(ucom4cpu *cpu)
 {
 	// these opcodes are officially only supported on uCOM-43
 	if (cpu->family != NEC_UCOM43)
-		printf("Using uCOM-43 opcode $%02X at $%03X\n", cpu->op, cpu->prev_pc);
+		vlog(LOG_CPU, LOG_WARN, "Using uCOM-43 opcode $%02X at $%03X\n", cpu->op, cpu->prev_pc);
 
 	return (cpu->family == NEC_UCOM43);
 }
@@ -890,7 +891,7 @@ void op_stm(ucom4cpu *cpu)
 	cpu->tc += (cpu->old_icount - cpu->icount);
 
 	if ((cpu->arg & 0xc0) != 0x80)
-		printf("STM opcode unexpected upper arg $%02X at $%03X\n", cpu->arg & 0xc0, cpu->prev_pc);
+		vlog(LOG_CPU, LOG_WARN, "STM opcode unexpected upper arg $%02X at $%03X\n", cpu->arg & 0xc0, cpu->prev_pc);
 }
 
 void op_ttm(ucom4cpu *cpu)
@@ -926,10 +927,13 @@ void op_di(ucom4cpu *cpu)
 
 
 void sound_buf(ucom4cpu *cpu, int ticks) {
+	uint8_t *buf = cpu->audio_buf;
+
 	cpu->sample_count += ticks * cpu->sound_frequency;
     while (cpu->sample_count >= cpu->cpu_rate) {
         cpu->sample_count -= cpu->cpu_rate;
-		audiobuf[cpu->aindex]=cpu->audio_level;
+		if(buf)
+			buf[cpu->aindex]=cpu->audio_level;
 		cpu->aindex++;
 
 		if(cpu->aindex>=10240) 
@@ -949,16 +953,14 @@ void sound_buf(ucom4cpu *cpu, int ticks) {
 }
 
 
-int overflow = 0;
-
 int32_t ucom4_exec(ucom4cpu *cpu, int32_t ticks) {
 	int32_t totalticks = 0;
 	int tickused = 0;
 	cpu->icount = ticks;
 	
-	overflow +=ticks;
+	cpu->overflow +=ticks;
 
-	while(overflow>0) {
+	while(cpu->overflow>0) {
 		cpu->old_icount = cpu->icount;
 
 		// handle interrupt, but not during LI($9x) or EI($31) or while skipping
@@ -975,6 +977,7 @@ int32_t ucom4_exec(ucom4cpu *cpu, int32_t ticks) {
 
 		// fetch next opcode
 		cpu->icount--;
+		cpu->instructions++;
 		read_op(cpu);
 		cpu->bitmask = 1 << (cpu->op & 0x03);
 		increment_pc(cpu);
@@ -1093,7 +1096,16 @@ int32_t ucom4_exec(ucom4cpu *cpu, int32_t ticks) {
 		cpu->sound_ticks += tickused;
 		cpu->totalticks += tickused;
 
-		overflow -= tickused;
+		cpu->overflow -= tickused;
+
+		if (cpu->profile)
+		{
+			cpu->profile->pc_count[cpu->prev_pc]++;
+			cpu->profile->pc_cycles[cpu->prev_pc] += tickused;
+		}
+
+		if (cpu->trace)
+			ucom4_trace_step(cpu->trace, cpu, tickused);
 
 		sound_buf(cpu, tickused);
 
@@ -14,6 +14,7 @@
 #include <stdint.h>
 
 #define STACK_SIZE 3
+#define UCOM4_ROM_SIZE 0x800
 #define BIT(x,n) (((x)>>(n))&1)
 
 #define BITSWAP8(val,B7,B6,B5,B4,B3,B2,B1,B0) \
@@ -114,7 +115,6 @@ typedef struct _ucom4cpu {
 	uint8_t int_f;
 	uint8_t inte_f;
 	int32_t int_line;
-	uint8_t rom[0x800];
 	uint8_t ram[0x80];
 	uint8_t datamask;
 	uint8_t bitmask;
@@ -123,6 +123,7 @@ typedef struct _ucom4cpu {
 	uint8_t family;
 	int icount;
 	int old_icount;
+	int overflow;                     // ticks run past (or short of) the last exec budget
 	uint8_t inp_mux ;
 
 	uint32_t grid;
@@ -140,11 +141,22 @@ typedef struct _ucom4cpu {
 	uint8_t audio_level;
 	int sound_ticks;
 	int totalticks;
+	uint32_t instructions;            // opcodes executed, wraps around
 	int aindex;
 	int audio_avail;
 	int cpu_rate;
 	int sample_count;
 	int sound_frequency;
+
+	// host side hooks from here on, not part of the machine state
+	struct _gamedriver *game;         // driver doing this cpu's i/o
+	const uint8_t *rom;               // UCOM4_ROM_SIZE bytes, shared by every cpu running it
+	uint8_t *inputs;                  // input lines read by the driver, INPUTS_NUM of them
+	void *state;                      // driver state block, game->state_size bytes
+	struct _nvstore *store;           // file behind the driver's non volatile memory, or NULL
+	struct _ucom4_profile *profile;
+	struct _ucom4_trace *trace;
+	uint8_t *audio_buf;               // sample ring of 10240, NULL counts samples without keeping them
 } ucom4cpu;
 
 void ucom4_reset(ucom4cpu *cpu);
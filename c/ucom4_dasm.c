@@ -0,0 +1,119 @@
+/************************
+ *
+ * UCOM4 DISASSEMBLER
+ *
+ * (c) 2016 MikeDX
+ *
+ * Thanks to MAME Source
+ *
+ *************************/
+
+#include <stdio.h>
+
+#include "ucom4_dasm.h"
+
+#define OP(n,b,a,f) { n, b, UCOM4_ARG_##a, UCOM4_FLOW_##f }
+
+const ucom4_opinfo ucom4_ops[0x100] =
+{
+	[0x00] = OP("NOP",  1, NONE, NEXT),  [0x01] = OP("DI",   1, NONE, NEXT),
+	[0x02] = OP("S",    1, NONE, NEXT),  [0x03] = OP("TIT",  1, NONE, SKIP),
+	[0x04] = OP("TC",   1, NONE, SKIP),  [0x05] = OP("TTM",  1, NONE, SKIP),
+	[0x06] = OP("DAA",  1, NONE, NEXT),  [0x07] = OP("TAL",  1, NONE, NEXT),
+	[0x08] = OP("AD",   1, NONE, SKIP),  [0x09] = OP("ADS",  1, NONE, SKIP),
+	[0x0a] = OP("DAS",  1, NONE, NEXT),  [0x0b] = OP("CLC",  1, NONE, NEXT),
+	[0x0c] = OP("CM",   1, NONE, SKIP),  [0x0d] = OP("INC",  1, NONE, SKIP),
+	[0x0e] = OP("OP",   1, NONE, NEXT),  [0x0f] = OP("DEC",  1, NONE, SKIP),
+	[0x10] = OP("CMA",  1, NONE, NEXT),  [0x11] = OP("CIA",  1, NONE, NEXT),
+	[0x12] = OP("TLA",  1, NONE, NEXT),  [0x13] = OP("DED",  1, NONE, SKIP),
+	[0x14] = OP("STM",  2, IMM8, NEXT),  [0x15] = OP("LDI",  2, IMM8, NEXT),
+	[0x16] = OP("CLI",  2, IMM8, SKIP),  [0x17] = OP("CI",   2, IMM8, SKIP),
+	[0x18] = OP("EXL",  1, NONE, NEXT),  [0x19] = OP("ADC",  1, NONE, NEXT),
+	[0x1a] = OP("XC",   1, NONE, NEXT),  [0x1b] = OP("STC",  1, NONE, NEXT),
+	[0x1c] = OP("?",    1, NONE, NEXT),  [0x1d] = OP("INM",  1, NONE, SKIP),
+	[0x1e] = OP("OCD",  2, IMM8, NEXT),  [0x1f] = OP("DEM",  1, NONE, SKIP),
+
+	[0x20 ... 0x23] = OP("FBF", 1, BIT, SKIP),
+	[0x24 ... 0x27] = OP("TAB", 1, BIT, SKIP),
+	[0x28 ... 0x2b] = OP("XM",  1, XOR, NEXT),
+	[0x2c ... 0x2f] = OP("XMD", 1, XOR, SKIP),
+
+	[0x30] = OP("RAR",  1, NONE, NEXT),  [0x31] = OP("EI",   1, NONE, NEXT),
+	[0x32] = OP("IP",   1, NONE, NEXT),  [0x33] = OP("IND",  1, NONE, SKIP),
+
+	[0x34 ... 0x37] = OP("CMB", 1, BIT, SKIP),
+	[0x38 ... 0x3b] = OP("LM",  1, XOR, NEXT),
+	[0x3c ... 0x3f] = OP("XMI", 1, XOR, SKIP),
+
+	[0x40] = OP("IA",   1, NONE, NEXT),  [0x41] = OP("JPA",  1, NONE, TABLE),
+	[0x42] = OP("TAZ",  1, NONE, NEXT),  [0x43] = OP("TAW",  1, NONE, NEXT),
+	[0x44] = OP("OE",   1, NONE, NEXT),  [0x45] = OP("?",    1, NONE, NEXT),
+	[0x46] = OP("TLY",  1, NONE, NEXT),  [0x47] = OP("THX",  1, NONE, NEXT),
+	[0x48] = OP("RT",   1, NONE, RET),  [0x49] = OP("RTS",  1, NONE, RETS),
+	[0x4a] = OP("XAZ",  1, NONE, NEXT),  [0x4b] = OP("XAW",  1, NONE, NEXT),
+	[0x4c] = OP("XLS",  1, NONE, NEXT),  [0x4d] = OP("XHR",  1, NONE, NEXT),
+	[0x4e] = OP("XLY",  1, NONE, NEXT),  [0x4f] = OP("XHX",  1, NONE, NEXT),
+
+	[0x50 ... 0x53] = OP("TPB", 1, BIT, SKIP),
+	[0x54 ... 0x57] = OP("TPA", 1, BIT, SKIP),
+	[0x58 ... 0x5b] = OP("TMB", 1, BIT, SKIP),
+	[0x5c ... 0x5f] = OP("FBT", 1, BIT, SKIP),
+	[0x60 ... 0x63] = OP("RPB", 1, BIT, NEXT),
+	[0x64 ... 0x67] = OP("REB", 1, BIT, NEXT),
+	[0x68 ... 0x6b] = OP("RMB", 1, BIT, NEXT),
+	[0x6c ... 0x6f] = OP("RFB", 1, BIT, NEXT),
+	[0x70 ... 0x73] = OP("SPB", 1, BIT, NEXT),
+	[0x74 ... 0x77] = OP("SEB", 1, BIT, NEXT),
+	[0x78 ... 0x7b] = OP("SMB", 1, BIT, NEXT),
+	[0x7c ... 0x7f] = OP("SFB", 1, BIT, NEXT),
+
+	[0x80 ... 0x8f] = OP("LDZ", 1, IMM4, NEXT),
+	[0x90 ... 0x9f] = OP("LI",  1, IMM4, NEXT),
+	[0xa0 ... 0xa7] = OP("JMP", 2, ADDR, JUMP),
+	[0xa8 ... 0xaf] = OP("CAL", 2, ADDR, CALL),
+	[0xb0 ... 0xbf] = OP("CZP", 1, CZP, CALL),
+	[0xc0 ... 0xff] = OP("JCP", 1, JCP, JUMP)
+};
+
+// static target of a JMP/CAL/CZP/JCP at pc, -1 for anything else
+
+int ucom4_branch_target(uint16_t pc, uint8_t op, uint8_t arg)
+{
+	switch (ucom4_ops[op].arg)
+	{
+		case UCOM4_ARG_ADDR: return (op & 0x07) << 8 | arg;
+		case UCOM4_ARG_CZP:  return (op & 0x0f) << 2;
+		case UCOM4_ARG_JCP:  return (UCOM4_NEXT_PC(pc) & ~0x3f) | (op & 0x3f);
+		default:             return -1;
+	}
+}
+
+// disassemble an already fetched instruction at pc
+
+void ucom4_disasm_op(char *buf, uint16_t pc, uint8_t op, uint8_t arg)
+{
+	const ucom4_opinfo *info = &ucom4_ops[op];
+
+	switch (info->arg)
+	{
+		case UCOM4_ARG_BIT:
+		case UCOM4_ARG_XOR:  sprintf(buf, "%-4s %d", info->name, op & 0x03); break;
+		case UCOM4_ARG_IMM4: sprintf(buf, "%-4s $%X", info->name, op & 0x0f); break;
+		case UCOM4_ARG_IMM8: sprintf(buf, "%-4s $%02X", info->name, arg); break;
+		case UCOM4_ARG_ADDR:
+		case UCOM4_ARG_CZP:
+		case UCOM4_ARG_JCP:  sprintf(buf, "%-4s $%03X", info->name, ucom4_branch_target(pc, op, arg)); break;
+		default:             sprintf(buf, "%s", info->name); break;
+	}
+}
+
+// disassemble one instruction at pc, returns its length in bytes
+
+int ucom4_disasm(char *buf, uint16_t pc, const uint8_t *rom)
+{
+	uint8_t op = rom[pc & 0x7ff];
+
+	ucom4_disasm_op(buf, pc, op, rom[UCOM4_NEXT_PC(pc)]);
+
+	return ucom4_ops[op].bytes;
+}
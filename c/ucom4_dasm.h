@@ -0,0 +1,57 @@
+/************************
+ *
+ * UCOM4 DISASSEMBLER
+ *
+ * (c) 2016 MikeDX
+ *
+ * Thanks to MAME Source
+ *
+ *************************/
+
+#ifndef _UCOM4_DASM_H_
+#define _UCOM4_DASM_H_
+
+#include <stdint.h>
+
+// operand encodings
+enum
+{
+	UCOM4_ARG_NONE = 0,
+	UCOM4_ARG_BIT,          // B: op & 3
+	UCOM4_ARG_XOR,          // X: op & 3, xor'ed into DPh
+	UCOM4_ARG_IMM4,         // X: op & f
+	UCOM4_ARG_IMM8,         // X: second byte
+	UCOM4_ARG_ADDR,         // A: (op & 7) << 8 | second byte
+	UCOM4_ARG_CZP,          // A: (op & f) << 2
+	UCOM4_ARG_JCP           // A: op & 3f in current page
+};
+
+// control flow after the instruction
+enum
+{
+	UCOM4_FLOW_NEXT = 0,    // falls through
+	UCOM4_FLOW_SKIP,        // may skip the next instruction
+	UCOM4_FLOW_JUMP,        // JMP, JCP
+	UCOM4_FLOW_CALL,        // CAL, CZP
+	UCOM4_FLOW_RET,         // RT
+	UCOM4_FLOW_RETS,        // RTS, returns and skips
+	UCOM4_FLOW_TABLE        // JPA, jumps to (ACC) << 2 in current page
+};
+
+typedef struct _ucom4_opinfo {
+	const char *name;
+	uint8_t bytes;
+	uint8_t arg;
+	uint8_t flow;
+} ucom4_opinfo;
+
+extern const ucom4_opinfo ucom4_ops[0x100];
+
+// the pc only increments within its 256 byte page
+#define UCOM4_NEXT_PC(pc)   ((((pc) & ~0xff) | (((pc) + 1) & 0xff)) & 0x7ff)
+
+int ucom4_branch_target(uint16_t pc, uint8_t op, uint8_t arg);
+void ucom4_disasm_op(char *buf, uint16_t pc, uint8_t op, uint8_t arg);
+int ucom4_disasm(char *buf, uint16_t pc, const uint8_t *rom);
+
+#endif
@@ -0,0 +1,707 @@
+/************************
+ *
+ * UCOM4 LOCKSTEP LANES
+ *
+ * (c) 2016 MikeDX
+ *
+ *************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ucom4_lanes.h"
+#include "driver.h"
+#include "ucom4_dasm.h"
+
+#define LANE_FAST   0       // executed on the lane arrays
+#define LANE_SCALAR 1       // one lane at a time through the normal core
+#define LANE_43     2       // uCOM-43 only, the core just warns on the others
+
+static uint8_t lane_class[0x100];
+
+static void lanes_classify(void)
+{
+	int x;
+
+	for (x = 0; x < 0x100; x++)
+		lane_class[x] = LANE_FAST;
+
+	lane_class[0x1c] = LANE_SCALAR;                                 // illegal
+	lane_class[0x45] = LANE_SCALAR;
+
+	static const uint8_t ucom43[] = {
+		0x01, 0x05, 0x14, 0x1a, 0x1d, 0x1f, 0x30, 0x31,
+		0x42, 0x43, 0x46, 0x47, 0x4a, 0x4b, 0x4c, 0x4d, 0x4e, 0x4f
+	};
+	for (x = 0; x < (int)sizeof(ucom43); x++)
+		lane_class[ucom43[x]] = LANE_43;
+	for (x = 0; x < 4; x++) {
+		lane_class[0x20 + x] = LANE_43;                             // FBF FBT RFB SFB
+		lane_class[0x5c + x] = LANE_43;
+		lane_class[0x6c + x] = LANE_43;
+		lane_class[0x7c + x] = LANE_43;
+	}
+}
+
+// the timer is a deadline on totalticks, it sets timer_f once read after it
+
+#define LANE_TIMER(l)                                                       \
+	if (L->timer_on[l] && L->totalticks[l] - L->timer_at[l] >= 0) {         \
+		L->timer_f[l] = 1;                                                  \
+		L->timer_on[l] = 0;                                                 \
+	}
+
+// move one lane between the arrays and its machine's cpu. The budget
+// (until, hold) is only read back by ucom4_lanes_load.
+
+static void lane_put(ucom4_lanes *L, int l, ucom4cpu *cpu, int ram)
+{
+	int x;
+
+	LANE_TIMER(l);
+
+	cpu->pc = L->pc[l];
+	cpu->prev_pc = L->prev_pc[l];
+	for (x = 0; x < STACK_SIZE; x++)
+		cpu->stack[x] = L->stack[x * L->count + l];
+	cpu->op = L->op[l];
+	cpu->prev_op = L->prev_op[l];
+	cpu->arg = L->arg[l];
+	cpu->bitmask = L->bitmask[l];
+	cpu->skip = L->skip[l];
+	cpu->acc = L->acc[l];
+	cpu->dpl = L->dpl[l];
+	cpu->dph = L->dph[l];
+	cpu->carry_f = L->carry_f[l];
+	cpu->carry_s_f = L->carry_s_f[l];
+	cpu->timer_f = L->timer_f[l];
+	cpu->int_f = L->int_f[l];
+	cpu->inte_f = L->inte_f[l];
+	cpu->tc = L->timer_on[l] ? L->timer_at[l] - L->totalticks[l] : 0;
+	cpu->overflow = L->until[l] - L->totalticks[l] + L->hold[l];
+	cpu->totalticks = L->totalticks[l];
+	cpu->decay_ticks = L->totalticks[l] - L->decay_base[l];
+	cpu->sound_ticks = L->totalticks[l] - L->sound_base[l];
+	cpu->instructions = L->instructions[l];
+	if (ram)
+		for (x = 0; x < 0x80; x++)
+			cpu->ram[x] = L->ram[x * L->count + l];
+}
+
+static void lane_get(ucom4_lanes *L, int l, ucom4cpu *cpu, int ram)
+{
+	int x;
+
+	L->pc[l] = cpu->pc;
+	L->prev_pc[l] = cpu->prev_pc;
+	for (x = 0; x < STACK_SIZE; x++)
+		L->stack[x * L->count + l] = cpu->stack[x];
+	L->op[l] = cpu->op;
+	L->prev_op[l] = cpu->prev_op;
+	L->arg[l] = cpu->arg;
+	L->bitmask[l] = cpu->bitmask;
+	L->skip[l] = cpu->skip;
+	L->acc[l] = cpu->acc;
+	L->dpl[l] = cpu->dpl;
+	L->dph[l] = cpu->dph;
+	L->carry_f[l] = cpu->carry_f;
+	L->carry_s_f[l] = cpu->carry_s_f;
+	L->timer_f[l] = cpu->timer_f;
+	L->timer_on[l] = cpu->tc > 0;
+	L->int_f[l] = cpu->int_f;
+	L->inte_f[l] = cpu->inte_f;
+	L->totalticks[l] = cpu->totalticks;
+	L->timer_at[l] = cpu->totalticks + cpu->tc;
+	L->decay_base[l] = cpu->totalticks - cpu->decay_ticks;
+	L->sound_base[l] = cpu->totalticks - cpu->sound_ticks;
+	L->instructions[l] = cpu->instructions;
+	if (ram)
+		for (x = 0; x < 0x80; x++)
+			L->ram[x * L->count + l] = cpu->ram[x];
+}
+
+// One instruction of one lane through the normal core. What is left for
+// it (illegal opcodes, uCOM-43 ones on other cpus, odd operands) never
+// touches RAM, so RAM stays in the lanes.
+
+static void lane_scalar_step(ucom4_lanes *L, int l)
+{
+	ucom4cpu *cpu = L->cpu[L->id[l]];
+	int32_t until = L->until[l], hold = L->hold[l];
+
+	if (L->extra[l]) {
+		L->totalticks[l] += L->extra[l];
+		L->extra[l] = 0;
+		L->owed--;
+	}
+
+	lane_put(L, l, cpu, 0);
+	cpu->overflow = 0;
+	ucom4_exec(cpu, 1);
+	lane_get(L, l, cpu, 0);
+	L->until[l] = until;
+	L->hold[l] = hold;
+	L->fallbacks++;
+}
+
+ucom4_lanes *ucom4_lanes_create(ucom4cpu **cpus, int count)
+{
+	ucom4_lanes *L;
+	int x, n = count;
+
+	if (count < 1)
+		return NULL;
+
+	for (x = 1; x < count; x++)
+		if (cpus[x]->rom != cpus[0]->rom && memcmp(cpus[x]->rom, cpus[0]->rom, UCOM4_ROM_SIZE))
+			return NULL;
+
+	if (!lane_class[0x01])
+		lanes_classify();
+
+	L = calloc(1, sizeof(ucom4_lanes));
+	if (!L)
+		return NULL;
+
+	L->count = count;
+	L->rom = cpus[0]->rom;
+	L->datamask = cpus[0]->datamask;
+	L->ucom43 = (cpus[0]->family == NEC_UCOM43);
+
+	L->cpu = malloc(n * sizeof(ucom4cpu *));
+	L->id = malloc(n * sizeof(int));
+	L->pc = malloc(n * sizeof(uint16_t));
+	L->prev_pc = malloc(n * sizeof(uint16_t));
+	L->stack = malloc(STACK_SIZE * n * sizeof(uint16_t));
+	L->op = malloc(n);
+	L->prev_op = malloc(n);
+	L->arg = malloc(n);
+	L->bitmask = malloc(n);
+	L->skip = malloc(n);
+	L->acc = malloc(n);
+	L->dpl = malloc(n);
+	L->dph = malloc(n);
+	L->carry_f = malloc(n);
+	L->carry_s_f = malloc(n);
+	L->timer_f = malloc(n);
+	L->timer_on = malloc(n);
+	L->int_f = malloc(n);
+	L->inte_f = malloc(n);
+	L->extra = calloc(n, 1);
+	L->ram = malloc(0x80 * n);
+	L->totalticks = malloc(n * sizeof(int32_t));
+	L->until = malloc(n * sizeof(int32_t));
+	L->hold = malloc(n * sizeof(int32_t));
+	L->iend = malloc(n * sizeof(int32_t));
+	L->timer_at = malloc(n * sizeof(int32_t));
+	L->decay_base = malloc(n * sizeof(int32_t));
+	L->sound_base = malloc(n * sizeof(int32_t));
+	L->instructions = malloc(n * sizeof(uint32_t));
+	L->gstart = malloc(n * sizeof(int));
+	L->gend = malloc(n * sizeof(int));
+	L->nstart = malloc(n * sizeof(int));
+	L->nend = malloc(n * sizeof(int));
+	L->scratch = malloc(n * sizeof(int32_t));           // one row of the widest field
+	L->perm = malloc(n * sizeof(int));
+	L->bucket = malloc((0x800 + 2) * sizeof(int));
+	L->seen = calloc(0x800, sizeof(int));
+
+	if (!L->cpu || !L->id || !L->pc || !L->prev_pc || !L->stack || !L->op || !L->prev_op ||
+	    !L->arg || !L->bitmask || !L->skip || !L->acc || !L->dpl || !L->dph || !L->carry_f ||
+	    !L->carry_s_f || !L->timer_f || !L->timer_on || !L->int_f || !L->inte_f || !L->extra || !L->ram ||
+	    !L->totalticks || !L->until || !L->hold || !L->iend || !L->timer_at ||
+	    !L->decay_base || !L->sound_base || !L->instructions ||
+	    !L->gstart || !L->gend || !L->nstart || !L->nend || !L->scratch || !L->perm || !L->bucket || !L->seen) {
+		ucom4_lanes_destroy(L);
+		return NULL;
+	}
+
+	for (x = 0; x < count; x++)
+		L->cpu[x] = cpus[x];
+
+	ucom4_lanes_load(L);
+
+	return L;
+}
+
+void ucom4_lanes_destroy(ucom4_lanes *L)
+{
+	if (!L)
+		return;
+
+	free(L->cpu); free(L->id);
+	free(L->pc); free(L->prev_pc); free(L->stack);
+	free(L->op); free(L->prev_op); free(L->arg); free(L->bitmask); free(L->skip);
+	free(L->acc); free(L->dpl); free(L->dph);
+	free(L->carry_f); free(L->carry_s_f); free(L->timer_f); free(L->timer_on);
+	free(L->int_f); free(L->inte_f); free(L->extra); free(L->ram);
+	free(L->totalticks); free(L->until); free(L->hold); free(L->iend); free(L->timer_at);
+	free(L->decay_base); free(L->sound_base); free(L->instructions);
+	free(L->gstart); free(L->gend); free(L->nstart); free(L->nend); free(L->scratch); free(L->perm); free(L->bucket); free(L->seen);
+	free(L);
+}
+
+// (re)read every machine's cpu, after a reset or a state load
+
+void ucom4_lanes_load(ucom4_lanes *L)
+{
+	int x;
+
+	for (x = 0; x < L->count; x++) {
+		L->id[x] = x;
+		lane_get(L, x, L->cpu[x], 1);
+		L->until[x] = L->totalticks[x] + L->cpu[x]->overflow;
+		L->hold[x] = 0;
+		L->extra[x] = 0;
+	}
+	L->owed = 0;
+}
+
+// write the lanes back to the machines' cpus, e.g. before a save state
+
+void ucom4_lanes_sync(ucom4_lanes *L)
+{
+	int x;
+
+	for (x = 0; x < L->count; x++)
+		lane_put(L, x, L->cpu[L->id[x]], 1);
+}
+
+// Lanes are grouped by pc, lanes that used up their budget go last and
+// belong to no group.
+
+#define LANE_LEFT(l)    (L->until[l] - L->totalticks[l])
+#define LANE_KEY(l)     (LANE_LEFT(l) > 0 ? L->pc[l] : 0x800)
+
+#define PERMUTE(field, type, rows)                                          \
+	do {                                                                    \
+		type *tmp = (type *)L->scratch;                                     \
+		for (r = 0; r < (rows); r++) {                                      \
+			type *row = (field) + r * n;                                    \
+			for (x = s; x < e; x++)                                         \
+				tmp[x - s] = row[L->perm[x]];                               \
+			memcpy(row + s, tmp, (size_t)(e - s) * sizeof(type));           \
+		}                                                                   \
+	} while (0)
+
+// move lane perm[x] to x for the lanes [s, e)
+
+static void lanes_permute(ucom4_lanes *L, int s, int e)
+{
+	int n = L->count, x, r;
+
+	PERMUTE(L->id, int, 1);
+	PERMUTE(L->pc, uint16_t, 1);
+	PERMUTE(L->prev_pc, uint16_t, 1);
+	PERMUTE(L->stack, uint16_t, STACK_SIZE);
+	PERMUTE(L->op, uint8_t, 1);
+	PERMUTE(L->prev_op, uint8_t, 1);
+	PERMUTE(L->arg, uint8_t, 1);
+	PERMUTE(L->bitmask, uint8_t, 1);
+	PERMUTE(L->skip, uint8_t, 1);
+	PERMUTE(L->acc, uint8_t, 1);
+	PERMUTE(L->dpl, uint8_t, 1);
+	PERMUTE(L->dph, uint8_t, 1);
+	PERMUTE(L->carry_f, uint8_t, 1);
+	PERMUTE(L->carry_s_f, uint8_t, 1);
+	PERMUTE(L->timer_f, uint8_t, 1);
+	PERMUTE(L->timer_on, uint8_t, 1);
+	PERMUTE(L->int_f, uint8_t, 1);
+	PERMUTE(L->inte_f, uint8_t, 1);
+	PERMUTE(L->extra, uint8_t, 1);
+	PERMUTE(L->ram, uint8_t, 0x80);
+	PERMUTE(L->totalticks, int32_t, 1);
+	PERMUTE(L->until, int32_t, 1);
+	PERMUTE(L->hold, int32_t, 1);
+	PERMUTE(L->iend, int32_t, 1);
+	PERMUTE(L->timer_at, int32_t, 1);
+	PERMUTE(L->decay_base, int32_t, 1);
+	PERMUTE(L->sound_base, int32_t, 1);
+	PERMUTE(L->instructions, uint32_t, 1);
+}
+
+// Regroup all lanes: a stable counting sort on the pc, so lanes that
+// met at the same pc again end up in one group.
+
+static void lanes_regroup(ucom4_lanes *L)
+{
+	int n = L->count, x, key, sum;
+	int *bucket = L->bucket;
+
+	memset(bucket, 0, (0x800 + 2) * sizeof(int));
+	for (x = 0; x < n; x++)
+		bucket[LANE_KEY(x) + 1]++;
+
+	L->ngroups = 0;
+	for (key = 0, sum = 0; key < 0x800; key++) {
+		if (bucket[key + 1]) {
+			L->gstart[L->ngroups] = sum;
+			L->gend[L->ngroups++] = sum + bucket[key + 1];
+		}
+		sum += bucket[key + 1];
+		bucket[key + 1] = sum;
+	}
+
+	for (x = 0; x < n; x++)
+		L->perm[bucket[LANE_KEY(x)]++] = x;
+
+	for (x = 0; x < n && L->perm[x] == x; x++)
+		;
+	if (x == n)
+		return;
+
+	L->regroups++;
+	lanes_permute(L, 0, n);
+}
+
+// Partition a group whose lanes went different ways and add the parts
+// to the next round's groups. Returns 0 if there are too many parts.
+
+#define LANES_SPLIT_MAX 32
+
+static int lanes_split(ucom4_lanes *L, int s, int e, int *ng)
+{
+	int keys[LANES_SPLIT_MAX], start[LANES_SPLIT_MAX], end[LANES_SPLIT_MAX];
+	int nk = 0, k, x, key, pos;
+
+	for (x = s; x < e; x++) {
+		key = LANE_KEY(x);
+		for (k = 0; k < nk && keys[k] != key; k++)
+			;
+		if (k == nk) {
+			if (nk == LANES_SPLIT_MAX)
+				return 0;
+			keys[nk] = key;
+			end[nk++] = 0;
+		}
+		end[k]++;
+	}
+
+	for (k = 0, pos = s; k < nk; k++) {
+		start[k] = pos;
+		pos += end[k];
+		end[k] = start[k];
+	}
+
+	for (x = s; x < e; x++) {
+		key = LANE_KEY(x);
+		for (k = 0; keys[k] != key; k++)
+			;
+		L->perm[end[k]++] = x;
+	}
+
+	lanes_permute(L, s, e);
+	L->splits++;
+
+	for (k = 0; k < nk; k++) {
+		if (keys[k] == 0x800)
+			continue;
+		L->nstart[*ng] = start[k];
+		L->nend[(*ng)++] = end[k];
+	}
+
+	return 1;
+}
+
+// Loop over a group for one instruction: fetch bookkeeping, the opcode
+// body unless the lane skips it, then the cycles. EXTRA is the cycle an
+// executed (not skipped) op adds. The arrays are cached in restrict
+// locals, so the stores to them do not force reloads of the pointers.
+
+#define RAM(l)      ram[(((dph[l] << 4) | dpl[l]) & datamask) * n + (l)]
+#define REG(l, r)   ram[(datamask - (r)) * n + (l)]         // uCOM-43 registers live in RAM
+
+#define LANES(EXTRA, ...)                                                   \
+	for (l = s; l < e; l++) {                                               \
+		uint8_t live = !skip[l];                                            \
+		skip[l] = 0;                                                        \
+		prev_op[l] = ops[l];                                                \
+		ops[l] = live ? op : 0;                                             \
+		pc[l] = next;                                                       \
+		instructions[l]++;                                                  \
+		if (live) { __VA_ARGS__ }                                           \
+		totalticks[l] += bytes + (live ? (EXTRA) : 0);                      \
+	}
+
+// port i/o goes to the lane's own cpu with its clock; the display code
+// reads and consumes decay_ticks
+
+#define IO(...)                                                             \
+	{                                                                       \
+		ucom4cpu *c = L->cpu[L->id[l]];                                     \
+		c->totalticks = totalticks[l];                                      \
+		c->decay_ticks = totalticks[l] - L->decay_base[l];                  \
+		__VA_ARGS__                                                         \
+		L->decay_base[l] = totalticks[l] - c->decay_ticks;                  \
+	}
+
+#define PUSH(ret)                                                           \
+	stack[2 * n + l] = stack[n + l];                                        \
+	stack[n + l] = stack[l];                                                \
+	stack[l] = (ret);
+
+#define POP()                                                               \
+	pc[l] = stack[l] & 0x7ff;                                               \
+	stack[l] = stack[n + l];                                                \
+	stack[n + l] = stack[2 * n + l];
+
+enum { UCOM43_X = 0, UCOM43_Y, UCOM43_R, UCOM43_S, UCOM43_W, UCOM43_Z, UCOM43_F };
+
+// Take the pending interrupts of the lanes [s, e), as the core does at
+// the top of its loop. Its cycle goes with the next instruction, unless
+// it used up the last cycle of this exec, which ends the lane's run
+// like the core's break does. Returns 1 if any lane took one.
+
+static int lanes_interrupt(ucom4_lanes *L, int s, int e)
+{
+	int n = L->count, l, taken = 0;
+	uint16_t *restrict pc = L->pc;
+	uint16_t *restrict stack = L->stack;
+
+	for (l = s; l < e; l++) {
+		if (!L->int_f[l] || !L->inte_f[l] || (L->op[l] & 0xf0) == 0x90 || L->op[l] == 0x31 || L->skip[l])
+			continue;
+
+		PUSH(pc[l])
+		pc[l] = 0xf << 2;
+		L->int_f[l] = 0;
+		L->inte_f[l] = !L->ucom43;
+		taken = 1;
+
+		if (L->iend[l] - L->totalticks[l] <= 1) {
+			L->hold[l] += LANE_LEFT(l);
+			L->until[l] = L->totalticks[l];
+		} else {
+			L->extra[l] = 1;
+			L->owed++;
+		}
+	}
+
+	return taken;
+}
+
+// Run one instruction on the lanes [s, e), which all sit at the same pc.
+// Returns 1 if afterwards they no longer do, or some ran out of budget.
+
+static int lanes_step(ucom4_lanes *L, int s, int e)
+{
+	int n = L->count, l;
+	uint16_t at = L->pc[s];
+	uint8_t op = L->rom[at];
+	uint8_t bytes = ucom4_ops[op].bytes;
+	uint8_t arg = L->rom[UCOM4_NEXT_PC(at)];
+	uint8_t bm = 1 << (op & 0x03);
+	uint16_t next = bytes == 2 ? UCOM4_NEXT_PC(UCOM4_NEXT_PC(at)) : UCOM4_NEXT_PC(at);
+	uint8_t datamask = L->datamask;
+	uint8_t pending = 0;
+	int cls = lane_class[op];
+	int split = 0;
+
+	uint16_t *restrict pc = L->pc;
+	uint16_t *restrict stack = L->stack;
+	uint8_t *restrict ops = L->op;
+	uint8_t *restrict prev_op = L->prev_op;
+	uint8_t *restrict skip = L->skip;
+	uint8_t *restrict acc = L->acc;
+	uint8_t *restrict dpl = L->dpl;
+	uint8_t *restrict dph = L->dph;
+	uint8_t *restrict carry_f = L->carry_f;
+	uint8_t *restrict int_f = L->int_f;
+	uint8_t *restrict inte_f = L->inte_f;
+	uint8_t *restrict ram = L->ram;
+	int32_t *restrict totalticks = L->totalticks;
+	uint32_t *restrict instructions = L->instructions;
+
+	for (l = s; l < e; l++)
+		pending |= int_f[l] & inte_f[l];
+	if (pending && lanes_interrupt(L, s, e))
+		return 1;
+
+	// the ones the core warns about go its way, so the warning is kept
+	if (cls == LANE_43)
+		cls = L->ucom43 ? LANE_FAST : LANE_SCALAR;
+	if ((op == 0x16 && (arg & 0xf0) != 0xe0) || (op == 0x17 && (arg & 0xf0) != 0xc0) || (op == 0x14 && (arg & 0xc0) != 0x80))
+		cls = LANE_SCALAR;
+
+	if (cls != LANE_FAST) {
+		for (l = s; l < e; l++)
+			lane_scalar_step(L, l);
+		goto done;
+	}
+
+	// the same for the whole group
+	for (l = s; l < e; l++) {
+		L->prev_pc[l] = at;
+		L->bitmask[l] = bm;
+	}
+	if (bytes == 2)
+		for (l = s; l < e; l++)
+			L->arg[l] = arg;
+
+	switch (op & 0xf0) {
+		case 0x80: LANES(0, dph[l] = 0; dpl[l] = op & 0x0f;) break;
+		case 0x90: LANES(0, if ((prev_op[l] & 0xf0) != 0x90) acc[l] = op & 0x0f;) break;
+		case 0xa0:
+			if (op & 0x08)
+				LANES(0, PUSH(next) pc[l] = (op & 0x07) << 8 | arg;)
+			else
+				LANES(0, pc[l] = (op & 0x07) << 8 | arg;)
+			break;
+		case 0xb0: LANES(0, PUSH(next) pc[l] = (op & 0x0f) << 2;) break;
+		case 0xc0: case 0xd0: case 0xe0: case 0xf0:
+			LANES(0, pc[l] = (next & ~0x3f) | (op & 0x3f);) break;
+
+		default:
+			switch (op)
+			{
+		case 0x00: LANES(0, ) break;
+		case 0x01: LANES(0, inte_f[l] = 0;) break;
+		case 0x02: LANES(0, RAM(l) = acc[l];) break;
+		case 0x03: LANES(0, skip[l] = int_f[l] != 0; int_f[l] = 0;) break;
+		case 0x04: LANES(0, skip[l] = carry_f[l] != 0;) break;
+		case 0x05: LANES(0, LANE_TIMER(l) skip[l] = L->timer_f[l] != 0;) break;
+		case 0x06: LANES(0, acc[l] = (acc[l] + 6) & 0xf;) break;
+		case 0x07: LANES(0, dpl[l] = acc[l];) break;
+		case 0x08: LANES(0, uint8_t a = acc[l] + (RAM(l) & 0xf); skip[l] = (a & 0x10) != 0; acc[l] = a & 0xf;) break;
+		case 0x09: LANES(0, uint8_t a = acc[l] + (RAM(l) & 0xf) + carry_f[l]; carry_f[l] = a >> 4 & 1; skip[l] = carry_f[l]; acc[l] = a & 0xf;) break;
+		case 0x0a: LANES(0, acc[l] = (acc[l] + 10) & 0xf;) break;
+		case 0x0b: LANES(0, carry_f[l] = 0;) break;
+		case 0x0c: LANES(0, skip[l] = acc[l] == (RAM(l) & 0xf);) break;
+		case 0x0d: LANES(0, acc[l] = (acc[l] + 1) & 0xf; skip[l] = acc[l] == 0;) break;
+		case 0x0e: LANES(0, IO(c->game->output_w(c, dpl[l], acc[l]);)) break;
+		case 0x0f: LANES(0, acc[l] = (acc[l] - 1) & 0xf; skip[l] = acc[l] == 0xf;) break;
+		case 0x10: LANES(0, acc[l] ^= 0xf;) break;
+		case 0x11: LANES(0, acc[l] = ((acc[l] ^ 0xf) + 1) & 0xf;) break;
+		case 0x12: LANES(0, acc[l] = dpl[l];) break;
+		case 0x13: LANES(0, dpl[l] = (dpl[l] - 1) & 0xf; skip[l] = dpl[l] == 0xf;) break;
+		case 0x14: LANES(0, L->timer_f[l] = 0; L->timer_on[l] = 1;
+		                    L->timer_at[l] = totalticks[l] + bytes + L->extra[l] + ((arg & 0x3f) + 1) * 63;) break;
+		case 0x15: LANES(0, dph[l] = arg >> 4 & 0xf; dpl[l] = arg & 0x0f;) break;
+		case 0x16: LANES(0, skip[l] = dpl[l] == (arg & 0x0f);) break;
+		case 0x17: LANES(0, skip[l] = acc[l] == (arg & 0x0f);) break;
+		case 0x18: LANES(0, acc[l] ^= RAM(l) & 0xf;) break;
+		case 0x19: LANES(0, uint8_t a = acc[l] + (RAM(l) & 0xf) + carry_f[l]; carry_f[l] = a >> 4 & 1; acc[l] = a & 0xf;) break;
+		case 0x1a: LANES(0, uint8_t c = carry_f[l]; carry_f[l] = L->carry_s_f[l]; L->carry_s_f[l] = c;) break;
+		case 0x1b: LANES(0, carry_f[l] = 1;) break;
+		case 0x1d: LANES(0, uint8_t v = ((RAM(l) & 0xf) + 1) & 0xf; RAM(l) = v; skip[l] = v == 0;) break;
+		case 0x1e: LANES(0, IO(c->game->output_w(c, NEC_UCOM4_PORTD, arg >> 4); c->game->output_w(c, NEC_UCOM4_PORTC, arg & 0xf);)) break;
+		case 0x1f: LANES(0, uint8_t v = ((RAM(l) & 0xf) - 1) & 0xf; RAM(l) = v; skip[l] = v == 0xf;) break;
+		case 0x30: LANES(0, uint8_t c = acc[l] & 1; acc[l] = acc[l] >> 1 | carry_f[l] << 3; carry_f[l] = c;) break;
+		case 0x31: LANES(0, inte_f[l] = 1;) break;
+		case 0x32: LANES(0, IO(acc[l] = c->game->input_r(c, dpl[l]);)) break;
+		case 0x33: LANES(0, dpl[l] = (dpl[l] + 1) & 0xf; skip[l] = dpl[l] == 0;) break;
+		case 0x40: LANES(1, IO(acc[l] = c->game->input_r(c, NEC_UCOM4_PORTA);)) break;
+		case 0x41: LANES(1, pc[l] = (next & ~0x3f) | (acc[l] << 2);) break;
+		case 0x42: LANES(1, REG(l, UCOM43_Z) = acc[l];) break;
+		case 0x43: LANES(1, REG(l, UCOM43_W) = acc[l];) break;
+		case 0x44: LANES(1, IO(c->game->output_w(c, NEC_UCOM4_PORTE, acc[l]);)) break;
+		case 0x46: LANES(1, REG(l, UCOM43_Y) = dpl[l];) break;
+		case 0x47: LANES(1, REG(l, UCOM43_X) = dph[l];) break;
+		case 0x48: LANES(1, POP()) break;
+		case 0x49: LANES(1, POP() skip[l] = 1;) break;
+		case 0x4a: LANES(1, uint8_t a = acc[l]; acc[l] = REG(l, UCOM43_Z) & 0xf; REG(l, UCOM43_Z) = a;) break;
+		case 0x4b: LANES(1, uint8_t a = acc[l]; acc[l] = REG(l, UCOM43_W) & 0xf; REG(l, UCOM43_W) = a;) break;
+		case 0x4c: LANES(1, uint8_t a = dpl[l]; dpl[l] = REG(l, UCOM43_S) & 0xf; REG(l, UCOM43_S) = a;) break;
+		case 0x4d: LANES(1, uint8_t a = dph[l]; dph[l] = REG(l, UCOM43_R) & 0xf; REG(l, UCOM43_R) = a;) break;
+		case 0x4e: LANES(1, uint8_t a = dpl[l]; dpl[l] = REG(l, UCOM43_Y) & 0xf; REG(l, UCOM43_Y) = a;) break;
+		case 0x4f: LANES(1, uint8_t a = dph[l]; dph[l] = REG(l, UCOM43_X) & 0xf; REG(l, UCOM43_X) = a;) break;
+
+		default:
+			switch (op & 0xfc)
+			{
+		case 0x20: LANES(1, skip[l] = (REG(l, UCOM43_F) & bm) == 0;) break;
+		case 0x24: LANES(0, skip[l] = (acc[l] & bm) != 0;) break;
+		case 0x28: LANES(0, uint8_t a = acc[l]; acc[l] = RAM(l) & 0xf; RAM(l) = a; dph[l] ^= op & 0x03;) break;
+		case 0x2c: LANES(0, uint8_t a = acc[l]; acc[l] = RAM(l) & 0xf; RAM(l) = a; dph[l] ^= op & 0x03;
+		                    dpl[l] = (dpl[l] - 1) & 0xf; skip[l] = dpl[l] == 0xf;) break;
+		case 0x34: LANES(0, skip[l] = (acc[l] & bm) == (RAM(l) & bm);) break;
+		case 0x38: LANES(0, acc[l] = RAM(l) & 0xf; dph[l] ^= op & 0x03;) break;
+		case 0x3c: LANES(0, uint8_t a = acc[l]; acc[l] = RAM(l) & 0xf; RAM(l) = a; dph[l] ^= op & 0x03;
+		                    dpl[l] = (dpl[l] + 1) & 0xf; skip[l] = dpl[l] == 0;) break;
+		case 0x50: LANES(0, IO(skip[l] = (c->game->input_r(c, dpl[l]) & bm) != 0;)) break;
+		case 0x54: LANES(0, IO(skip[l] = (c->game->input_r(c, NEC_UCOM4_PORTA) & bm) != 0;)) break;
+		case 0x58: LANES(0, skip[l] = (RAM(l) & bm) != 0;) break;
+		case 0x5c: LANES(1, skip[l] = (REG(l, UCOM43_F) & bm) != 0;) break;
+		case 0x60: LANES(0, IO(c->game->output_w(c, dpl[l], c->port_out[dpl[l]] & ~bm);)) break;
+		case 0x64: LANES(1, IO(c->game->output_w(c, NEC_UCOM4_PORTE, c->port_out[NEC_UCOM4_PORTE] & ~bm);)) break;
+		case 0x68: LANES(0, RAM(l) = RAM(l) & 0xf & ~bm;) break;
+		case 0x6c: LANES(1, REG(l, UCOM43_F) = REG(l, UCOM43_F) & 0xf & ~bm;) break;
+		case 0x70: LANES(0, IO(c->game->output_w(c, dpl[l], c->port_out[dpl[l]] | bm);)) break;
+		case 0x74: LANES(1, IO(c->game->output_w(c, NEC_UCOM4_PORTE, c->port_out[NEC_UCOM4_PORTE] | bm);)) break;
+		case 0x78: LANES(0, RAM(l) = (RAM(l) & 0xf) | bm;) break;
+		case 0x7c: LANES(1, REG(l, UCOM43_F) = (REG(l, UCOM43_F) & 0xf) | bm;) break;
+			}
+			break;
+			}
+			break;
+	}
+
+	// interrupt cycles taken before this instruction
+	if (L->owed)
+		for (l = s; l < e; l++)
+			if (L->extra[l]) {
+				totalticks[l] += L->extra[l];
+				L->extra[l] = 0;
+				L->owed--;
+			}
+
+done:
+	for (l = s; l < e; l++)
+		split |= (pc[l] != pc[s]) | (LANE_LEFT(l) <= 0);
+
+	return split;
+}
+
+// Run every lane for ticks more cycles. Each round steps every group by
+// one instruction. Groups that split are partitioned in place; groups
+// that meet at the same pc again are merged by a full regroup, at most
+// every LANES_MERGE rounds.
+
+#define LANES_MERGE 32
+
+void ucom4_lanes_exec(ucom4_lanes *L, int32_t ticks)
+{
+	int g, ng, x, full, dup, *swap;
+	uint16_t pc;
+
+	for (x = 0; x < L->count; x++) {
+		L->until[x] += ticks + L->hold[x];
+		L->hold[x] = 0;
+		L->iend[x] = L->totalticks[x] + ticks;
+	}
+
+	lanes_regroup(L);
+	L->merged = L->step;
+
+	while (L->ngroups) {
+		ng = 0;
+		full = 0;
+		dup = 0;
+		L->step++;
+
+		for (g = 0; g < L->ngroups; g++) {
+			if (!lanes_step(L, L->gstart[g], L->gend[g])) {
+				L->nstart[ng] = L->gstart[g];
+				L->nend[ng++] = L->gend[g];
+			} else if (!lanes_split(L, L->gstart[g], L->gend[g], &ng)) {
+				full = 1;
+			}
+		}
+
+		swap = L->gstart; L->gstart = L->nstart; L->nstart = swap;
+		swap = L->gend; L->gend = L->nend; L->nend = swap;
+		L->ngroups = ng;
+
+		for (g = 0; g < L->ngroups; g++) {
+			pc = L->pc[L->gstart[g]];
+			dup |= (L->seen[pc] == L->step);
+			L->seen[pc] = L->step;
+		}
+
+		if (full || (dup && L->step - L->merged >= LANES_MERGE)) {
+			lanes_regroup(L);
+			L->merged = L->step;
+		}
+	}
+}
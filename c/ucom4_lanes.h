@@ -0,0 +1,85 @@
+/************************
+ *
+ * UCOM4 LOCKSTEP LANES
+ *
+ * (c) 2016 MikeDX
+ *
+ * Runs many copies of one ROM together. The hot cpu state lives in
+ * per-lane arrays, lanes at the same pc sit next to each other and
+ * execute each instruction as one loop over the group. Port i/o goes
+ * to each lane's own cpu; only illegal opcodes and the ones the core
+ * warns about go through the normal core one lane at a time.
+ *
+ *************************/
+
+#ifndef _UCOM4_LANES_H_
+#define _UCOM4_LANES_H_
+
+#include <stdint.h>
+#include "ucom4_cpu.h"
+
+typedef struct _ucom4_lanes {
+	int count;
+	const uint8_t *rom;                 // shared, all lanes run the same rom
+	uint8_t datamask;
+	uint8_t ucom43;
+
+	ucom4cpu **cpu;                     // by machine: the full cpu, i/o hooks, display
+	int *id;                            // by lane: machine index
+
+	// hot state, by lane. Cycle counts are kept as offsets from
+	// totalticks, so an instruction only bumps totalticks: the budget
+	// runs out at until, the timer fires at timer_at.
+	uint16_t *pc;
+	uint16_t *prev_pc;
+	uint16_t *stack;                    // STACK_SIZE rows of count
+	uint8_t *op;
+	uint8_t *prev_op;
+	uint8_t *arg;
+	uint8_t *bitmask;
+	uint8_t *skip;
+	uint8_t *acc;
+	uint8_t *dpl;
+	uint8_t *dph;
+	uint8_t *carry_f;
+	uint8_t *carry_s_f;
+	uint8_t *timer_f;
+	uint8_t *timer_on;
+	uint8_t *int_f;
+	uint8_t *inte_f;
+	uint8_t *extra;                     // interrupt cycle, charged with the next instruction
+	uint8_t *ram;                       // 0x80 rows of count
+	int32_t *totalticks;
+	int32_t *until;
+	int32_t *hold;                      // budget kept for the next exec
+	int32_t *iend;                      // totalticks where this exec's own ticks end
+	int32_t *timer_at;
+	int32_t *decay_base;
+	int32_t *sound_base;
+	uint32_t *instructions;
+	int owed;                           // lanes with extra set
+
+	// group g is the lanes [gstart[g], gend[g]), all at one pc
+	int *gstart, *gend;
+	int *nstart, *nend;                 // next round's groups
+	int ngroups;
+	int merged;                         // step of the last full regroup
+
+	uint8_t *scratch;
+	int *perm;
+	int *bucket;
+	int *seen;
+	int step;
+
+	uint64_t fallbacks;                 // lane steps that went through the scalar core
+	uint64_t regroups;
+	uint64_t splits;
+} ucom4_lanes;
+
+ucom4_lanes *ucom4_lanes_create(ucom4cpu **cpus, int count);
+void ucom4_lanes_destroy(ucom4_lanes *lanes);
+void ucom4_lanes_load(ucom4_lanes *lanes);
+void ucom4_lanes_sync(ucom4_lanes *lanes);
+void ucom4_lanes_exec(ucom4_lanes *lanes, int32_t ticks);
+
+#endif
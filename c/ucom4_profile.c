@@ -0,0 +1,97 @@
+/************************
+ *
+ * UCOM4 PROFILER
+ *
+ * (c) 2016 MikeDX
+ *
+ *************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ucom4_profile.h"
+#include "ucom4_dasm.h"
+
+typedef struct {
+	const char *name;
+	uint64_t count;
+	uint64_t cycles;
+} op_group;
+
+static ucom4_profile *sort_profile;
+
+static int compare_pc(const void *a, const void *b)
+{
+	uint64_t x = sort_profile->pc_cycles[*(const uint16_t *)a];
+	uint64_t y = sort_profile->pc_cycles[*(const uint16_t *)b];
+
+	return (x < y) - (x > y);
+}
+
+static int compare_group(const void *a, const void *b)
+{
+	uint64_t x = ((const op_group *)a)->cycles;
+	uint64_t y = ((const op_group *)b)->cycles;
+
+	return (x < y) - (x > y);
+}
+
+void ucom4_profile_dump(ucom4_profile *profile, const uint8_t *rom, FILE *f, int top)
+{
+	uint16_t order[0x800];
+	op_group groups[0x100];
+	uint64_t count = 0, cycles = 0;
+	int ngroups = 0;
+	int x, g;
+	char dasm[32];
+
+	for(x=0;x<0x800;x++) {
+		order[x] = x;
+		count += profile->pc_count[x];
+		cycles += profile->pc_cycles[x];
+
+		if(!profile->pc_count[x])
+			continue;
+
+		// group by mnemonic
+		for(g=0;g<ngroups;g++)
+			if(!strcmp(groups[g].name, ucom4_ops[rom[x]].name))
+				break;
+		if(g == ngroups) {
+			groups[g].name = ucom4_ops[rom[x]].name;
+			groups[g].count = 0;
+			groups[g].cycles = 0;
+			ngroups++;
+		}
+		groups[g].count += profile->pc_count[x];
+		groups[g].cycles += profile->pc_cycles[x];
+	}
+
+	if(!cycles)
+		return;
+
+	sort_profile = profile;
+	qsort(order, 0x800, sizeof(uint16_t), compare_pc);
+	qsort(groups, ngroups, sizeof(op_group), compare_group);
+
+	fprintf(f, "Profile: %llu instructions, %llu cycles\n",
+		(unsigned long long)count, (unsigned long long)cycles);
+	fprintf(f, " PC        count       cycles      %%  code\n");
+
+	for(x=0;x<top && x<0x800 && profile->pc_count[order[x]];x++) {
+		ucom4_disasm(dasm, order[x], rom);
+		fprintf(f, "%03X %12llu %12llu %6.2f  %s\n", order[x],
+			(unsigned long long)profile->pc_count[order[x]],
+			(unsigned long long)profile->pc_cycles[order[x]],
+			100.0 * profile->pc_cycles[order[x]] / cycles, dasm);
+	}
+
+	fprintf(f, " OP        count       cycles      %%\n");
+
+	for(g=0;g<ngroups;g++) {
+		fprintf(f, "%-4s%12llu %12llu %6.2f\n", groups[g].name,
+			(unsigned long long)groups[g].count,
+			(unsigned long long)groups[g].cycles,
+			100.0 * groups[g].cycles / cycles);
+	}
+}
@@ -0,0 +1,25 @@
+/************************
+ *
+ * UCOM4 PROFILER
+ *
+ * (c) 2016 MikeDX
+ *
+ *************************/
+
+#ifndef _UCOM4_PROFILE_H_
+#define _UCOM4_PROFILE_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+// attach to cpu->profile to count executions and cycles per rom address,
+// opcode statistics are derived from these when dumping
+
+typedef struct _ucom4_profile {
+	uint64_t pc_count[0x800];
+	uint64_t pc_cycles[0x800];
+} ucom4_profile;
+
+void ucom4_profile_dump(ucom4_profile *profile, const uint8_t *rom, FILE *f, int top);
+
+#endif
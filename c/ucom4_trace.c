@@ -0,0 +1,144 @@
+/************************
+ *
+ * UCOM4 TRACE RECORDER
+ *
+ * (c) 2016 MikeDX
+ *
+ * Records go into a large ring, a writer thread flushes them to disk in
+ * big sequential writes. The emulation only waits if the ring is full.
+ *
+ *************************/
+
+#include <stdlib.h>
+#include <sched.h>
+#include <time.h>
+
+#include "ucom4_trace.h"
+#include "ucom4_dasm.h"
+
+#define TRACE_CHUNK     (1 << 16)    // records per write
+
+static void trace_flush(ucom4_trace *trace, uint64_t tail, uint64_t head)
+{
+	uint64_t n;
+	uint32_t pos;
+
+	while(tail < head) {
+		// write up to the end of the ring, then wrap
+		pos = tail & trace->mask;
+		n = head - tail;
+		if(pos + n > trace->mask + 1)
+			n = trace->mask + 1 - pos;
+
+		fwrite(&trace->ring[pos], sizeof(ucom4_trace_rec), n, trace->f);
+		tail += n;
+		atomic_store_explicit(&trace->tail, tail, memory_order_release);
+	}
+}
+
+static void *trace_writer(void *data)
+{
+	ucom4_trace *trace = data;
+	struct timespec wait = { 0, 1000000 };
+	uint64_t head, tail;
+	int running;
+
+	do {
+		running = atomic_load_explicit(&trace->running, memory_order_acquire);
+		head = atomic_load_explicit(&trace->head, memory_order_acquire);
+		tail = atomic_load_explicit(&trace->tail, memory_order_relaxed);
+
+		if(head - tail >= TRACE_CHUNK || (!running && head != tail))
+			trace_flush(trace, tail, head);
+		else
+			nanosleep(&wait, NULL);
+	} while(running);
+
+	fflush(trace->f);
+
+	return NULL;
+}
+
+ucom4_trace *ucom4_trace_open(const char *file, int records)
+{
+	ucom4_trace_header header = { UCOM4_TRACE_MAGIC, UCOM4_TRACE_VERSION, sizeof(ucom4_trace_rec) };
+	ucom4_trace *trace;
+
+	if(records & (records - 1))
+		return NULL;
+
+	trace = calloc(1, sizeof(ucom4_trace));
+	if(!trace)
+		return NULL;
+
+	trace->f = fopen(file, "wb");
+	trace->ring = malloc(records * sizeof(ucom4_trace_rec));
+
+	if(!trace->f || !trace->ring) {
+		if(trace->f)
+			fclose(trace->f);
+		free(trace->ring);
+		free(trace);
+		return NULL;
+	}
+
+	fwrite(&header, sizeof(header), 1, trace->f);
+
+	trace->mask = records - 1;
+	atomic_init(&trace->head, 0);
+	atomic_init(&trace->tail, 0);
+	atomic_init(&trace->running, 1);
+
+	if(pthread_create(&trace->thread, NULL, trace_writer, trace)) {
+		fclose(trace->f);
+		free(trace->ring);
+		free(trace);
+		return NULL;
+	}
+
+	return trace;
+}
+
+void ucom4_trace_close(ucom4_trace *trace)
+{
+	if(!trace)
+		return;
+
+	atomic_store_explicit(&trace->running, 0, memory_order_release);
+	pthread_join(trace->thread, NULL);
+
+	fclose(trace->f);
+	free(trace->ring);
+	free(trace);
+}
+
+void ucom4_trace_step(ucom4_trace *trace, ucom4cpu *cpu, int cycles)
+{
+	uint64_t head = atomic_load_explicit(&trace->head, memory_order_relaxed);
+	ucom4_trace_rec *rec;
+	uint8_t op = cpu->rom[cpu->prev_pc];
+
+	// lossless: wait for the writer rather than drop records
+	if(head - atomic_load_explicit(&trace->tail, memory_order_acquire) > trace->mask) {
+		trace->stalls++;
+		while(head - atomic_load_explicit(&trace->tail, memory_order_acquire) > trace->mask)
+			sched_yield();
+	}
+
+	rec = &trace->ring[head & trace->mask];
+	rec->pc     = cpu->prev_pc;
+	rec->op     = op;
+	rec->arg    = (ucom4_ops[op].bytes == 2) ? cpu->arg : 0;
+	rec->acc    = cpu->acc;
+	rec->dp     = cpu->dph << 4 | cpu->dpl;
+	rec->cycles = cycles;
+	rec->flags  = (cpu->carry_f   ? UCOM4_TRACE_CARRY   : 0) |
+	              (cpu->carry_s_f ? UCOM4_TRACE_CARRY_S : 0) |
+	              (cpu->skip      ? UCOM4_TRACE_SKIP    : 0) |
+	              (cpu->int_f     ? UCOM4_TRACE_INT     : 0) |
+	              (cpu->inte_f    ? UCOM4_TRACE_INTE    : 0) |
+	              (cpu->timer_f   ? UCOM4_TRACE_TIMER   : 0) |
+	              (cpu->op != op  ? UCOM4_TRACE_SKIPPED : 0);
+
+	atomic_store_explicit(&trace->head, head + 1, memory_order_release);
+}
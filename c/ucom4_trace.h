@@ -0,0 +1,65 @@
+/************************
+ *
+ * UCOM4 TRACE RECORDER
+ *
+ * (c) 2016 MikeDX
+ *
+ *************************/
+
+#ifndef _UCOM4_TRACE_H_
+#define _UCOM4_TRACE_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "ucom4_cpu.h"
+
+#define UCOM4_TRACE_MAGIC      0x54344355    // "UC4T"
+#define UCOM4_TRACE_VERSION    1
+#define UCOM4_TRACE_RECORDS    (1 << 20)     // ring size, must be a power of 2
+
+// flags
+#define UCOM4_TRACE_CARRY      0x01
+#define UCOM4_TRACE_CARRY_S    0x02
+#define UCOM4_TRACE_SKIP       0x04          // next instruction will be skipped
+#define UCOM4_TRACE_INT        0x08
+#define UCOM4_TRACE_INTE       0x10
+#define UCOM4_TRACE_TIMER      0x20
+#define UCOM4_TRACE_SKIPPED    0x40          // this instruction was skipped
+
+// one executed instruction, registers as they are after it
+
+typedef struct _ucom4_trace_rec {
+	uint16_t pc;
+	uint8_t op;
+	uint8_t arg;
+	uint8_t acc;
+	uint8_t dp;          // dph << 4 | dpl
+	uint8_t flags;
+	uint8_t cycles;
+} ucom4_trace_rec;
+
+typedef struct _ucom4_trace_header {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t rec_size;
+} ucom4_trace_header;
+
+typedef struct _ucom4_trace {
+	ucom4_trace_rec *ring;
+	uint32_t mask;
+	atomic_uint_fast64_t head;   // next record to write, emulation thread
+	atomic_uint_fast64_t tail;   // next record to flush, writer thread
+	atomic_int running;
+	uint64_t stalls;             // times the emulation waited for the writer
+	FILE *f;
+	pthread_t thread;
+} ucom4_trace;
+
+ucom4_trace *ucom4_trace_open(const char *file, int records);
+void ucom4_trace_close(ucom4_trace *trace);
+void ucom4_trace_step(ucom4_trace *trace, ucom4cpu *cpu, int cycles);
+
+#endif
@@ -16,93 +16,291 @@
 
 #include "vfd_emu.h"
 #include "driver.h"
+#include "replay.h"
+#include "savestate.h"
+#include "rewind.h"
+#include "ucom4_profile.h"
+#include "ucom4_trace.h"
+#include "vfdlog.h"
+#include "pacer.h"
+#include "metrics.h"
+#include "latency.h"
+#include "render.h"
+#include "nvstore.h"
 
 #define FPS 50
-#define VOLUME 200
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
 #endif
 
 
-SDL_Surface *screen;
+uint8_t input_data;
+uint8_t old_input_data;
 
-vfd_game *active_game;
 
-#define MAX_EVENTS 65535
+uint8_t audiobuf[10240];                // cpu's sample ring, drained by the audio callback
+
+SDL_AudioSpec wanted, obtained;
+int sound_pos  = 0;
+int last_a = 0;
 
-// RECORD + PLAYBACK
 
+
+SDL_Surface *screen;
+vfd_game *active_game;
 uint8_t inputs[INPUTS_NUM];
+void *machine_state;                    // active_game's state block
 
-uint8_t input_data;
-uint8_t old_input_data;
+ucom4cpu cpu;
+vfd_render *render;
 
-struct input_event {
-  uint32_t cycle;
-  uint8_t val;
-} events[MAX_EVENTS], *pevent = NULL;
+int totalticks = 0;
+int running = 1;
 
+pacer frame_pacer;
+int pace_spin = 0;
 
-extern uint8_t audiobuf[1024];
-extern int aindex;
-extern int audiosize;
+SDL_Event event;
 
-SDL_AudioSpec wanted, obtained;
-int sound_pos  = 0;
-int last_a = 0;
+int store_open = 0;                     // the driver's open_store ran
 
+uint32_t get_ms() {
+	return SDL_GetTicks();
+}
 
+// QUICK SAVE / LOAD (in memory)
 
-ucom4cpu cpu;
+// set when the machine was taken back in time; the recording is cut back
+// to match before anything more is written
+int record_rewound = 0;
 
-int load_rom(ucom4cpu *cpu, char *file, int size) 
-{
-	FILE *f;
-	int len;
+uint8_t *quickstate = NULL;
+int quickstate_len = 0;
+
+void quick_save(void) {
+	if(!quickstate)
+		quickstate = malloc(savestate_size(&cpu));
+
+	SDL_LockAudio();
+	quickstate_len = savestate_save(&cpu, quickstate, savestate_size(&cpu));
+	SDL_UnlockAudio();
+
+	printf("State saved (%d bytes)\n", quickstate_len);
+}
+
+void quick_load(void) {
 	int result;
 
-	char rompath[1024];
+	if(!quickstate_len)
+		return;
 
-	strcpy(rompath,"res/");
-	strcat(rompath,file);
+	SDL_LockAudio();
+	result = savestate_load(&cpu, quickstate, quickstate_len);
+	SDL_UnlockAudio();
 
+	if(result) {
+		record_rewound = 1;
+		printf("State loaded\n");
+	}
+	else
+		printf("Failed to load state\n");
+}
 
-	f=fopen(rompath,"rb");
-	
-	if(!f) {
-		printf("Failed to open rom [%s]\n", rompath);
-		return 0;
+// REWIND
+
+rewind_buffer *rw = NULL;
+uint8_t *rewind_state = NULL;
+int rewinding = 0;
+
+void rewind_info(void) {
+	printf("Rewind: %.1f s history, %d bytes (%.1f KB per second)\n",
+		(double)rw->count / FPS, rw->bytes, rewind_bytes_per_second(rw, FPS) / 1024);
+}
+
+void rewind_frame(void) {
+	const uint8_t *state = rewind_step(rw);
+	uint8_t live[INPUTS_NUM];
+
+	if(!state)
+		return;
+
+	// keep the keys that are held right now
+	memcpy(live, inputs, sizeof(inputs));
+
+	SDL_LockAudio();
+	savestate_load(&cpu, state, savestate_size(&cpu));
+	cpu.audio_avail = 0;
+	SDL_UnlockAudio();
+	record_rewound = 1;
+
+	memcpy(inputs, live, sizeof(inputs));
+}
+
+// RUN-AHEAD
+// emulate a few frames ahead with the current inputs, show that display
+// and roll back. The driver renders from runahead_view instead of cpu.
+
+int runahead = 0;
+uint8_t *runahead_state = NULL;
+ucom4cpu runahead_view;
+
+void run_ahead(int frames) {
+	struct _ucom4_profile *profile = cpu.profile;
+	struct _ucom4_trace *trace = cpu.trace;
+	int x;
+
+	if(frames) {
+		SDL_LockAudio();
+		savestate_save(&cpu, runahead_state, savestate_size(&cpu));
+
+		// no samples, profile, trace or NVRAM writes from frames that
+		// will be thrown away
+		cpu.sound_frequency = 0;
+		cpu.profile = NULL;
+		cpu.trace = NULL;
+		nvstore_hold = 1;
+		for(x=0;x<frames;x++)
+			ucom4_exec(&cpu, cpu.cpu_rate/FPS);
+		nvstore_hold = 0;
 	}
 
-	fseek(f, 0, SEEK_END);
-	len = ftell(f);
-//	printf("ROM [%s]\nLENGTH: [0x%X]\n",file, len);
-	if(len!=size) {
-		fclose(f);
-		return 0;
+	memcpy(runahead_view.display_cache, cpu.display_cache, sizeof(cpu.display_cache));
+
+	if(frames) {
+		savestate_load(&cpu, runahead_state, savestate_size(&cpu));
+		cpu.profile = profile;
+		cpu.trace = trace;
+		SDL_UnlockAudio();
 	}
-	fseek(f, 0, SEEK_SET);
+}
 
-	result = fread(cpu->rom,1,len,f);
+// SPEED
+// the multiplier scales the cycles run per frame, SPEED_MAX runs frames
+// back to back. Audio is only kept at 1x. A frame that finishes when the
+// next one is already due is not drawn, up to MAX_FRAMESKIP in a row.
 
-	fclose(f);
-	
-	return result;	
+#define SPEED_MAX       0.0
+#define MAX_FRAMESKIP   8
+
+double speed = 1.0;
+const double speeds[] = { 0.25, 0.5, 1.0, 2.0, 4.0, 8.0, 16.0, SPEED_MAX };
+#define SPEEDS (int)(sizeof(speeds) / sizeof(speeds[0]))
+
+int audio_rate = 0;
+int frameskip = 0;
+uint32_t frames_skipped = 0;
+int64_t last_render = 0;
+
+int64_t stats_time = 0;
+int32_t stats_ticks = 0;
+uint32_t stats_skipped = 0;
+int show_stats = 0;
+int recording = 0;                      // -record, the speed keys are off
+int audio_overrun = 0;                  // the audio ring is past full
+
+void speed_step(int dir) {
+	int x;
 
+	if(recording) {
+		printf("Speed: fixed while recording\n");
+		return;
+	}
+
+	// first entry at or above the current speed, unlimited is the last one
+	for(x=0;x<SPEEDS-1 && (speed == SPEED_MAX || speeds[x] < speed);x++)
+		;
+
+	if(dir > 0) {
+		if(x < SPEEDS-1 && speeds[x] == speed)
+			x++;
+	} else if(x > 0) {
+		x--;
+	}
+
+	speed = speeds[x];
+	pacer_reset(&frame_pacer);
+
+	if(speed == SPEED_MAX)
+		printf("Speed: unlimited\n");
+	else
+		printf("Speed: %.2fx\n", speed);
 }
 
+int32_t frame_ticks(void) {
+	if(speed == SPEED_MAX || pevent)
+		return cpu.cpu_rate/FPS;
 
+	return (int32_t)(cpu.cpu_rate/FPS * speed);
+}
 
-int totalticks = 0;
-int running = 1;
+// INPUT LATENCY
+// every input change is timed up to the first drawn display it changes,
+// -latency prints the histogram at exit
 
-uint32_t next_ms = 0;
+latency input_latency;
+int show_latency = 0;
+uint32_t frame_count = 0;
 
-SDL_Event event;
+// draw this frame or let it go to catch up
 
-uint32_t get_ms() {
-	return SDL_GetTicks();
+void render_frame(void) {
+	int64_t now = pacer_now();
+	int draw;
+
+	if(speed == SPEED_MAX)
+		draw = now - last_render >= frame_pacer.period;
+	else
+		draw = now < frame_pacer.deadline || frameskip >= MAX_FRAMESKIP;
+
+	if(!draw) {
+		frameskip++;
+		frames_skipped++;
+		metrics_add(METRIC_FRAMES_SKIPPED, 1);
+		return;
+	}
+
+	render_update(render);
+	SDL_Flip(screen);
+	last_render = pacer_now();
+	frameskip = 0;
+
+	metrics_add(METRIC_FRAMES_RENDERED, 1);
+	metrics_set(METRIC_RENDER_US, (last_render - now) / 1000);
+	metrics_max(METRIC_RENDER_MAX_US, (last_render - now) / 1000);
+	if(latency_display(&input_latency, render->cpu->display_cache, cpu.totalticks, frame_count, last_render))
+		metrics_set(METRIC_INPUT_LATENCY_US, input_latency.last / 1000);
+}
+
+// once a second: how fast emulation really ran and what was skipped
+
+void speed_stats(void) {
+	int64_t now = pacer_now();
+	double effective;
+	char caption[320];
+
+	if(!stats_time) {
+		stats_time = now;
+		stats_ticks = cpu.totalticks;
+		return;
+	}
+
+	if(now - stats_time < 1000000000)
+		return;
+
+	effective = (double)(cpu.totalticks - stats_ticks) / cpu.cpu_rate / ((now - stats_time) / 1e9);
+
+	snprintf(caption, sizeof(caption), "%s %.2fx, %u skipped", active_game->name, effective, frames_skipped - stats_skipped);
+	SDL_WM_SetCaption(caption, NULL);
+	if(speed != 1.0 || frames_skipped != stats_skipped)
+		printf("Speed: %.2fx effective, %u frames skipped\n", effective, frames_skipped - stats_skipped);
+
+	if(show_stats)
+		metrics_line(stdout);
+
+	stats_time = now;
+	stats_ticks = cpu.totalticks;
+	stats_skipped = frames_skipped;
 }
 
 void do_inputs(void) {
@@ -186,6 +384,32 @@ void do_inputs(void) {
                         case SDLK_p: // REMOTE
                             inputs[18]=bit;
                             break;
+
+						case SDLK_F5: // QUICK SAVE
+							if(bit)
+								quick_save();
+							break;
+
+						case SDLK_F8: // QUICK LOAD
+							if(bit)
+								quick_load();
+							break;
+
+						case SDLK_MINUS: // SLOWER
+							if(bit)
+								speed_step(-1);
+							break;
+
+						case SDLK_EQUALS: // FASTER
+							if(bit)
+								speed_step(1);
+							break;
+
+						case SDLK_BACKSPACE: // REWIND (hold)
+							rewinding = bit;
+							if(bit && rw)
+								rewind_info();
+							break;
 //						case SDLK_q:
 //							running = 0;
 //							break;
@@ -209,6 +433,8 @@ void do_inputs(void) {
 void mainloop(void) {
 
 	int x = 0;
+	uint32_t instructions;
+	int32_t ticks;
 
 	do_inputs();
 
@@ -220,8 +446,9 @@ void mainloop(void) {
 // 	}
 // #endif
 
-	if(get_ms() >= next_ms || pevent) {
-		next_ms +=1000/FPS;
+	if(pevent || speed == SPEED_MAX || pacer_due(&frame_pacer)) {
+		if(!pevent && speed != SPEED_MAX)
+			pacer_advance(&frame_pacer);
 
 		input_data = 0;
 
@@ -229,16 +456,24 @@ void mainloop(void) {
 			input_data |= inputs[x]<<x;
 		}
 
-		if(!pevent && input_data!=old_input_data)
-			printf("%08x %02x\n", cpu.totalticks, input_data);
+		// the inputs held now are recorded again at the cycle rewound to
+		if(record_rewound && !(rewinding && rw)) {
+			replay_record_truncate(cpu.totalticks);
+			record_rewound = 0;
+			old_input_data = ~input_data;
+		}
+
+		if(!pevent && !(rewinding && rw) && input_data!=old_input_data) {
+			vlog(LOG_INPUT, LOG_INFO, "%08x %02x\n", cpu.totalticks, input_data);
+			replay_record_event(&cpu, input_data);
+			latency_input(&input_latency, render->cpu->display_cache, cpu.totalticks, frame_count, pacer_now());
+		}
 
 		old_input_data = input_data;
 
 		if(pevent) {
 			if (cpu.totalticks >= pevent->cycle) {
-				for(x=0;x<INPUTS_NUM;x++) {
-					inputs[x]=(pevent->val & (1<<x)) ? 1:0;
-				}
+				replay_apply(inputs, pevent->val);
 				++pevent;
 			}
 		}
@@ -246,7 +481,7 @@ void mainloop(void) {
 		if(pevent && !pevent->cycle) {
 			printf("Playback ended\n");
 			pevent = NULL;
-			next_ms = get_ms();
+			pacer_reset(&frame_pacer);
 			cpu.audio_avail = 0;
 		}
 
@@ -255,7 +490,47 @@ void mainloop(void) {
 		// 		inputs[x]=pinputs[x];
 		// }
 
-		totalticks +=ucom4_exec(&cpu, cpu.cpu_rate/FPS);//400000/284);
+		if(rewinding && rw) {
+			rewind_frame();
+		} else {
+			cpu.sound_frequency = (speed == 1.0 || pevent) ? audio_rate : 0;
+			instructions = cpu.instructions;
+			ticks = ucom4_exec(&cpu, frame_ticks());//400000/284);
+			totalticks += ticks;
+			frame_count++;
+
+			metrics_add(METRIC_CYCLES, ticks);
+			metrics_add(METRIC_INSTRUCTIONS, (uint32_t)(cpu.instructions - instructions));
+			metrics_set(METRIC_AUDIO_AVAIL, cpu.audio_avail);
+			// counted once per overrun, not for every frame it lasts
+			if(cpu.audio_avail > 10240) {
+				if(!audio_overrun)
+					metrics_add(METRIC_AUDIO_OVERRUNS, 1);
+				audio_overrun = 1;
+			} else {
+				audio_overrun = 0;
+			}
+
+			if(!pevent)
+				replay_record_frame(&cpu);
+			else if(replay_verify && !replay_check(&cpu)) {
+				printf("Playback stopped\n");
+				exit(1);
+			}
+
+			if(rw) {
+				savestate_save(&cpu, rewind_state, savestate_size(&cpu));
+				rewind_push(rw, rewind_state);
+			}
+		}
+
+		if(runahead && !pevent)
+			run_ahead(rewinding ? 0 : runahead);
+
+		if(!pevent) {
+			render_frame();
+			speed_stats();
+		}
 
 // #ifndef HAS_SDL
 // 		for(x=0;x<cpu.display_maxy;x++) {
@@ -269,23 +544,27 @@ void mainloop(void) {
 
 	}
 
-	if(!pevent) {
-//		if(get_ms()<next_ms+1000/FPS)
-			active_game->display_update();	
-	}
 }
 
-void level_w(ucom4cpu *cpu, uint8_t data) {
-	data *=VOLUME;
-	cpu->audio_level = data;
-}
+// FRAME PACING
+// sleep between frames instead of polling the clock, any event wakes us
+// up early so it is handled straight away
 
+int input_pending(void) {
+	SDL_Event peek;
+
+	SDL_PumpEvents();
+	return SDL_PeepEvents(&peek, 1, SDL_PEEKEVENT, SDL_ALLEVENTS) > 0;
+}
 
 void fill_audio(void *udata, Uint8 *stream, int len)
 {
 
 	int z;
 
+    if(len > cpu.audio_avail && cpu.sound_frequency)
+        metrics_add(METRIC_AUDIO_UNDERRUNS, 1);
+
     len = ( len > cpu.audio_avail ? cpu.audio_avail : len );
 
 	for(z=0;z<len;z++) {
@@ -320,12 +599,30 @@ int init_sound(void) {
         return(-1);
     }
     cpu.sound_frequency = obtained.freq;
+    audio_rate = obtained.freq;
 
     return(0);
 }
 
 void cleanup(void) {
-	active_game->close_gfx();
+	if(cpu.profile)
+		ucom4_profile_dump(cpu.profile, cpu.rom, stdout, 32);
+	replay_record_close();
+	if(store_open)
+		active_game->close_store(&cpu);
+	pacer_report(&frame_pacer);
+	if(show_latency)
+		latency_report(&input_latency, stdout, cpu.cpu_rate);
+	metrics_close();
+	if(cpu.trace) {
+		if(cpu.trace->stalls)
+			printf("Trace: waited for the writer %llu times\n", (unsigned long long)cpu.trace->stalls);
+		ucom4_trace_close(cpu.trace);
+		cpu.trace = NULL;
+	}
+	if(render)
+		render_destroy(render);
+	vfdlog_close();
 	SDL_CloseAudio();
 	SDL_Quit();
 
@@ -334,58 +631,180 @@ void cleanup(void) {
 
 int main(int argc, char *argv[])
 {
-
-	SDL_Init(SDL_INIT_EVERYTHING);
-	init_sound();
-	memset(audiobuf,0,sizeof(audiobuf));
+	int x;
+	int fast = 0;
+	int rewind_seconds = 0;
+	int record_hash = 0;
+	char *record = NULL;
 
 	atexit(cleanup);
 
-	active_game = &game_sonytaax44;
-//	active_game = &game_astrowars;
-//	active_game = &game_caveman;
+	active_game = driver_find(VFD_DEFAULT_DRIVER);
 
-	if(argc>1) {
-		if(!strcmp(argv[1],"caveman")) {
-			active_game = &game_caveman;
+	if(argc>1 && argv[1][0]!='-') {
+		active_game = driver_find(argv[1]);
+		if(!active_game) {
+			printf("Unknown driver %s, one of:", argv[1]);
+			for(x=0;vfd_drivers[x];x++)
+				printf(" %s", vfd_drivers[x]->name);
+			printf("\n");
+			return -1;
+		}
+		argv++;
+		argc--;
+	}
+
+	// -fast: run the replay headless at full host speed, then exit
+	// -rewind <seconds>: keep a rewind history (hold backspace)
+	// -runahead <frames>: show the display this many frames ahead
+	// -record <file>: write input changes to a replay file
+	// -hash: also record a state hash for every frame
+	// -verify: stop a replay at the first frame whose hash differs
+	// -profile: count executions per rom address, dump the hottest on exit
+	// -trace <file>: record every instruction, decode with tracedump
+	while(argc>1 && argv[1][0]=='-') {
+		if(!strcmp(argv[1],"-fast")) {
+			fast = 1;
+		} else if(!strcmp(argv[1],"-rewind") && argc>2) {
+			rewind_seconds = atoi(argv[2]);
+			argv++;
+			argc--;
+		} else if(!strcmp(argv[1],"-runahead") && argc>2) {
+			runahead = atoi(argv[2]);
+			argv++;
+			argc--;
+		} else if(!strcmp(argv[1],"-record") && argc>2) {
+			record = argv[2];
 			argv++;
 			argc--;
+		} else if(!strcmp(argv[1],"-hash")) {
+			record_hash = 1;
+		} else if(!strcmp(argv[1],"-verify")) {
+			replay_verify = 1;
+		} else if(!strcmp(argv[1],"-profile")) {
+			cpu.profile = calloc(1, sizeof(ucom4_profile));
+		} else if(!strcmp(argv[1],"-trace") && argc>2) {
+			cpu.trace = ucom4_trace_open(argv[2], UCOM4_TRACE_RECORDS);
+			if(!cpu.trace) {
+				printf("Cannot open trace file %s\n", argv[2]);
+				return -1;
+			}
+			argv++;
+			argc--;
+		} else if(!strcmp(argv[1],"-speed") && argc>2) {
+			speed = strcmp(argv[2],"max") ? atof(argv[2]) : SPEED_MAX;
+			if(speed != SPEED_MAX && speed < 0.25) {
+				printf("Speed must be 0.25 or more, or max\n");
+				return -1;
+			}
+			argv++;
+			argc--;
+		} else if(!strcmp(argv[1],"-latency")) {
+			show_latency = 1;
+		} else if(!strcmp(argv[1],"-stats")) {
+			show_stats = 1;
+		} else if(!strcmp(argv[1],"-metrics") && argc>2) {
+			if(metrics_serve(argv[2]) < 0) {
+				printf("Cannot serve metrics on %s\n", argv[2]);
+				return -1;
+			}
+			argv++;
+			argc--;
+		} else if(!strcmp(argv[1],"-spin")) {
+			pace_spin = 1;
+		} else if(!strcmp(argv[1],"-log") && argc>2) {
+			if(vfdlog_config(argv[2]) < 0) {
+				printf("Bad log spec %s\n", argv[2]);
+				return -1;
+			}
+			argv++;
+			argc--;
+		} else {
+			printf("Unknown option %s\n", argv[1]);
+			return -1;
 		}
+		argv++;
+		argc--;
 	}
 
-	if(argc>1) {
-		FILE *f = fopen(argv[1],"r");
-		if(!f) {
-			printf("Cannot open replay file\n");
-			return (-1);
-		}
+	vfdlog_start();
 
-    	for ( pevent = events ; 2 == fscanf(f, "%x %hhx", &(pevent->cycle), &(pevent->val)) ; pevent++ );
-	
-    	fclose(f);
+	// a replay is played back on 1x frames, events and hashes have to
+	// fall on the same frame boundaries
+	if(record && speed != 1.0 && speed != SPEED_MAX) {
+		printf("-record runs at speed 1 or max\n");
+		return -1;
+	}
 
-    	printf("replaying %lu events\n", pevent - events);
-    	pevent->cycle = 0;
-    	pevent = events;
+	if(argc>1) {
+		if(replay_load(argv[1]) < 0)
+			return (-1);
     	argc--,
     	argv++;
 
 	}
 
-	next_ms = get_ms();
+	pacer_init(&frame_pacer, FPS);
 
 	cpu.cpu_rate = 100000;
 
-	active_game->setup_gfx();
-
-	active_game->cpu = &cpu;
+	if(active_game->state_size && !(machine_state = calloc(1, active_game->state_size)))
+		return -1;
+	machine_attach(&cpu, active_game, inputs, machine_state);
+	cpu.audio_buf = audiobuf;
 
 	ucom4_reset(&cpu);
-	if(load_rom(&cpu, active_game->rom, active_game->romsize)!=active_game->romsize) {
+	if(load_rom(&cpu, active_game)!=active_game->romsize) {
 		printf("Failed to load astrowars.rom\n");
 		return -1;
 	}
 
+	// both replay paths start from the NVRAM in the file
+	if(pevent)
+		replay_nvram_load(&cpu);
+
+	// headless, before SDL: no window and no audio callback draining the ring
+	if(fast && pevent) {
+		cpu.sound_frequency = 0;
+		return replay_run_fast(&cpu) ? 0 : 1;
+	}
+
+	// the machine's own non volatile memory, for as long as it runs,
+	// a replay keeps off it
+	if(active_game->open_store && !pevent) {
+		active_game->open_store(&cpu);
+		store_open = 1;
+	}
+
+	SDL_Init(SDL_INIT_EVERYTHING);
+	init_sound();
+	memset(audiobuf,0,sizeof(audiobuf));
+
+	render = render_create(active_game, &cpu);
+	if(!render) {
+		printf("Failed to load graphics for %s\n", active_game->name);
+		return -1;
+	}
+	screen = SDL_SetVideoMode(render->w, render->h, 32, SDL_HWSURFACE);
+	render->out = screen;
+	SDL_PauseAudio(0);
+
+	if(record) {
+		if(replay_record_open(&cpu, record, record_hash) < 0)
+			return -1;
+		recording = 1;
+	}
+
+	if(rewind_seconds > 0) {
+		rw = rewind_create(rewind_seconds * FPS, savestate_size(&cpu));
+		rewind_state = malloc(savestate_size(&cpu));
+	}
+
+	if(runahead > 0) {
+		runahead_state = malloc(savestate_size(&cpu));
+		render->cpu = &runahead_view;
+	}
+
 	// active_game->cpu->rom[0x768]=0x0;
 	// active_game->cpu->rom[0x769]=0x0;
 //	active_game->cpu->rom[0x18]=0x48;
@@ -402,6 +821,8 @@ int main(int argc, char *argv[])
 #else
 	while(running) {
 		mainloop();
+		if(!pace_spin && !pevent && speed != SPEED_MAX)
+			pacer_wait(&frame_pacer, input_pending);
 	}
 
 	SDL_Quit();
@@ -12,6 +12,7 @@
 #define _VFD_EMU_H_
 
 #include "ucom4_cpu.h"
+#include "machine.h"
 #include <SDL.h>
 #include <SDL_image.h>
 
@@ -22,9 +23,8 @@
 #define GLOBAL
 #endif
 
-#define INPUTS_NUM          20
-
+// the frontend's own machine, each frontend defines what it uses
 extern SDL_Surface *screen;
-void level_w(ucom4cpu *cpu, uint8_t data);
+extern struct _gamedriver *active_game;
 extern uint8_t inputs[INPUTS_NUM];
 #endif
@@ -0,0 +1,326 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * vfdbench.c
+ *
+ * Headless benchmark: runs each driver for a fixed number of cycles, or a
+ * replay, frame by frame through ucom4_exec and prints one JSON line per
+ * driver. With -machines it runs that many copies through the batch
+ * runner instead, with -lanes in lockstep on the lanes core.
+ *
+ *************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "vfd_emu.h"
+#include "driver.h"
+#include "vfdlog.h"
+#include "replay.h"
+#include "batch.h"
+#include "ucom4_lanes.h"
+#include "ucom4_profile.h"
+
+#define FPS 50
+
+ucom4cpu cpu;
+uint8_t inputs[INPUTS_NUM];
+void *state;                            // driver state block of the game being run
+uint8_t audiobuf[10240];                // samples are made but nobody plays them
+
+FILE *out;
+
+int profile = 0;
+
+int machines = 0;
+int threads = 1;
+int lanes = 0;
+
+struct input_event *stream = NULL;
+int stream_count = 0;
+
+double get_seconds(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+int compare_double(const void *a, const void *b) {
+	double x = *(const double *)a, y = *(const double *)b;
+
+	return (x > y) - (x < y);
+}
+
+double percentile(double *sorted, int count, int pct) {
+	if(!count)
+		return 0;
+	return sorted[(count - 1) * pct / 100];
+}
+
+int bench_run(vfd_game *game, int cycles, int replay) {
+	ucom4_profile *prof = NULL;
+	int frames = 0, max_frames;
+	uint32_t instructions = 0, last;
+	double *latency;
+	double start, t, wall, emulated;
+
+	free(state);
+	state = NULL;
+	if(game->state_size && !(state = calloc(1, game->state_size)))
+		return -1;
+	machine_attach(&cpu, game, inputs, state);
+	cpu.audio_buf = audiobuf;
+
+	memset(inputs, 0, sizeof(inputs));
+
+	ucom4_reset(&cpu);
+	cpu.cpu_rate = 100000;
+	cpu.sound_frequency = 44100;
+
+	if(load_rom(&cpu, game) != game->romsize) {
+		fprintf(out, "{\"driver\":\"%s\",\"error\":\"failed to load rom %s\"}\n", game->name, game->rom);
+		return -1;
+	}
+
+	if(profile) {
+		prof = calloc(1, sizeof(ucom4_profile));
+		cpu.profile = prof;
+	}
+
+	if(replay) {
+		pevent = events;
+		max_frames = MAX_EVENTS * 64;
+	} else {
+		max_frames = cycles / (cpu.cpu_rate / FPS);
+	}
+
+	latency = malloc(max_frames * sizeof(double));
+	last = cpu.instructions;
+	start = get_seconds();
+
+	while(frames < max_frames) {
+		if(replay) {
+			if(pevent >= events + replay_count)
+				break;
+			if((uint32_t)cpu.totalticks >= pevent->cycle) {
+				replay_apply(inputs, pevent->val);
+				++pevent;
+			}
+		}
+
+		t = get_seconds();
+		ucom4_exec(&cpu, cpu.cpu_rate / FPS);
+		latency[frames++] = get_seconds() - t;
+
+		instructions += cpu.instructions - last;
+		last = cpu.instructions;
+	}
+
+	wall = get_seconds() - start;
+	emulated = (double)cpu.totalticks / cpu.cpu_rate;
+
+	qsort(latency, frames, sizeof(double), compare_double);
+
+	fprintf(out, "{\"driver\":\"%s\",\"mode\":\"%s\",\"frames\":%d,\"cycles\":%d,\"instructions\":%u,"
+		"\"wall_s\":%.6f,\"instructions_per_s\":%.0f,\"emulated_per_wall\":%.2f,"
+		"\"frame_us\":{\"p50\":%.3f,\"p90\":%.3f,\"p99\":%.3f,\"max\":%.3f}}\n",
+		game->name, replay ? "replay" : "cycles", frames, cpu.totalticks, instructions,
+		wall, wall > 0 ? instructions / wall : 0, wall > 0 ? emulated / wall : 0,
+		percentile(latency, frames, 50) * 1e6, percentile(latency, frames, 90) * 1e6,
+		percentile(latency, frames, 99) * 1e6, frames ? latency[frames - 1] * 1e6 : 0);
+	fflush(out);
+
+	if(prof) {
+		fprintf(stderr, "%s\n", game->name);
+		ucom4_profile_dump(prof, cpu.rom, stderr, 32);
+		cpu.profile = NULL;
+		free(prof);
+	}
+
+	free(latency);
+
+	return 0;
+}
+
+int bench_batch(vfd_game *game, int cycles) {
+	batch *b;
+	uint64_t instructions = 0;
+	double start, wall;
+	int x;
+
+	b = batch_create(game, machines, threads);
+	if(!b) {
+		fprintf(out, "{\"driver\":\"%s\",\"error\":\"failed to create batch\"}\n", game->name);
+		return -1;
+	}
+
+	for(x = 0; x < machines; x++) {
+		b->machines[x].events = stream;
+		b->machines[x].event_count = stream_count;
+	}
+
+	start = get_seconds();
+	batch_run(b, cycles);
+	wall = get_seconds() - start;
+
+	for(x = 0; x < machines; x++)
+		instructions += b->machines[x].cpu.instructions;
+
+	fprintf(out, "{\"driver\":\"%s\",\"mode\":\"batch\",\"machines\":%d,\"threads\":%d,\"cycles\":%d,"
+		"\"instructions\":%llu,\"wall_s\":%.6f,\"instructions_per_s\":%.0f,\"steals\":%llu}\n",
+		game->name, machines, threads, cycles, (unsigned long long)instructions, wall,
+		wall > 0 ? instructions / wall : 0, (unsigned long long)atomic_load(&b->steals));
+	fflush(out);
+
+	batch_destroy(b);
+
+	return 0;
+}
+
+// the same machines in lockstep, no replay input
+
+int bench_lanes(vfd_game *game, int cycles) {
+	batch *b;
+	ucom4_lanes *L = NULL;
+	ucom4cpu **cpus;
+	uint64_t instructions = 0;
+	double start, wall;
+	int x, done;
+
+	b = batch_create(game, machines, 1);
+	cpus = malloc(machines * sizeof(ucom4cpu *));
+	if(b && cpus) {
+		for(x = 0; x < machines; x++)
+			cpus[x] = &b->machines[x].cpu;
+		L = ucom4_lanes_create(cpus, machines);
+	}
+
+	if(!L) {
+		fprintf(out, "{\"driver\":\"%s\",\"error\":\"failed to create lanes\"}\n", game->name);
+		free(cpus);
+		batch_destroy(b);
+		return -1;
+	}
+
+	ucom4_lanes_load(L);
+
+	start = get_seconds();
+	for(done = 0; done < cycles; done += BATCH_SLICE)
+		ucom4_lanes_exec(L, cycles - done < BATCH_SLICE ? cycles - done : BATCH_SLICE);
+	wall = get_seconds() - start;
+
+	ucom4_lanes_sync(L);
+
+	for(x = 0; x < machines; x++)
+		instructions += b->machines[x].cpu.instructions;
+
+	fprintf(out, "{\"driver\":\"%s\",\"mode\":\"lanes\",\"machines\":%d,\"cycles\":%d,"
+		"\"instructions\":%llu,\"wall_s\":%.6f,\"instructions_per_s\":%.0f,\"fallbacks\":%llu,\"regroups\":%llu}\n",
+		game->name, machines, cycles, (unsigned long long)instructions, wall,
+		wall > 0 ? instructions / wall : 0, (unsigned long long)L->fallbacks, (unsigned long long)L->regroups);
+	fflush(out);
+
+	ucom4_lanes_destroy(L);
+	free(cpus);
+	batch_destroy(b);
+
+	return 0;
+}
+
+void usage(void) {
+	fprintf(stderr, "usage: vfdbench [-cycles n] [-replay file] [-profile] [-machines n [-threads n | -lanes]] [driver ...]\n");
+	fprintf(stderr, "drivers:");
+	for(vfd_game **game = vfd_drivers; *game; game++)
+		fprintf(stderr, " %s", (*game)->name);
+	fprintf(stderr, "\n");
+}
+
+int main(int argc, char *argv[])
+{
+	int cycles = 100000 * 60;
+	char *replay = NULL;
+	int selected = 0;
+	int result = 0;
+	vfd_game **game;
+
+	vfdlog_start();
+
+	while(argc>1 && argv[1][0]=='-') {
+		if(!strcmp(argv[1],"-cycles") && argc>2) {
+			cycles = atoi(argv[2]);
+			argv++;
+			argc--;
+		} else if(!strcmp(argv[1],"-profile")) {
+			profile = 1;
+		} else if(!strcmp(argv[1],"-machines") && argc>2) {
+			machines = atoi(argv[2]);
+			argv++;
+			argc--;
+		} else if(!strcmp(argv[1],"-threads") && argc>2) {
+			threads = atoi(argv[2]);
+			argv++;
+			argc--;
+		} else if(!strcmp(argv[1],"-lanes")) {
+			lanes = 1;
+		} else if(!strcmp(argv[1],"-replay") && argc>2) {
+			replay = argv[2];
+			argv++;
+			argc--;
+		} else {
+			usage();
+			return -1;
+		}
+		argv++;
+		argc--;
+	}
+
+	// results go to stdout, driver chatter does not
+	out = fdopen(dup(fileno(stdout)), "w");
+	freopen("/dev/null", "w", stdout);
+
+	if(replay && machines && !(stream = replay_load_stream(replay, &stream_count))) {
+		fprintf(stderr, "Cannot open replay file %s\n", replay);
+		return -1;
+	}
+
+	if(replay && !machines && replay_load(replay) < 0) {
+		fprintf(stderr, "Cannot open replay file %s\n", replay);
+		return -1;
+	}
+
+	for(game = vfd_drivers; *game; game++) {
+		int run = (argc <= 1);
+
+		for(int x = 1; x < argc; x++)
+			if(!strcmp(argv[x], (*game)->name))
+				run = 1;
+
+		if(!run)
+			continue;
+
+		selected++;
+		if(machines && lanes) {
+			if(bench_lanes(*game, cycles) < 0)
+				result = 1;
+		} else if(machines) {
+			if(bench_batch(*game, cycles) < 0)
+				result = 1;
+		} else if(bench_run(*game, cycles, replay != NULL) < 0)
+			result = 1;
+	}
+
+	if(!selected) {
+		usage();
+		return -1;
+	}
+
+	return result;
+}
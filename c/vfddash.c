@@ -0,0 +1,394 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * vfddash.c
+ *
+ * Dashboard: runs several machines of any drivers, each on its own
+ * emulation thread, and tiles their displays into one window. Tiles are
+ * given as driver[:scale[:replay]], a replay file drives that unit's
+ * inputs. Only tiles whose display changed, or that were waiting on a
+ * segment image, are drawn and updated.
+ *
+ *************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "vfd_emu.h"
+#include "driver.h"
+#include "vfdlog.h"
+#include "render.h"
+#include "replay.h"
+#include "pacer.h"
+#include "lib/SDL_rotozoom.h"
+
+#define FPS 50
+#define MAX_TILES 64
+#define DEFAULT_SCALE 0.5
+
+// one display handed from an emulation thread to the render thread.
+// The writer fills the half the reader was not told about and then flips
+// front; a reader that sees the half's sequence move (or odd) took a torn
+// copy and tries again. Neither side ever waits on the other.
+
+typedef struct _dash_snapshot {
+	uint32_t cache[2][0x20];
+	uint32_t gen[2];                    // publish count of each half
+	atomic_uint seq[2];                 // odd while that half is written
+	atomic_uint front;
+	uint32_t published;                 // writer only
+} dash_snapshot;
+
+typedef struct _dash_tile {
+	vfd_game *game;
+	double scale;
+
+	// emulation thread
+	ucom4cpu cpu;
+	uint8_t inputs[INPUTS_NUM];
+	void *state;
+	struct input_event *events;
+	int event_count;
+	int next_event;
+	uint32_t shown[0x20];               // last display published
+	pacer pacer;
+	pthread_t thread;
+	int started;
+	uint32_t frames;
+
+	dash_snapshot snap;
+
+	// render thread
+	ucom4cpu view;                      // the snapshot the tile draws from
+	vfd_render *render;
+	SDL_Rect rect;                      // scaled, in the window
+	uint32_t drawn;                     // gen on screen
+	unsigned loaded;                    // segment images decoded when it was drawn
+	uint32_t updates;
+} dash_tile;
+
+SDL_Surface *screen;
+
+dash_tile tiles[MAX_TILES];
+int tile_count = 0;
+int cols = 0;
+
+atomic_int running;
+
+void snapshot_publish(dash_snapshot *s, const uint32_t *cache)
+{
+	unsigned back = !atomic_load_explicit(&s->front, memory_order_relaxed);
+
+	atomic_fetch_add_explicit(&s->seq[back], 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	memcpy(s->cache[back], cache, sizeof(s->cache[back]));
+	s->gen[back] = ++s->published;
+	atomic_fetch_add_explicit(&s->seq[back], 1, memory_order_release);
+	atomic_store_explicit(&s->front, back, memory_order_release);
+}
+
+// copy the newest display into cache, returns its publish count
+
+uint32_t snapshot_read(dash_snapshot *s, uint32_t *cache)
+{
+	unsigned f, seq;
+	uint32_t gen;
+
+	for(;;) {
+		f = atomic_load_explicit(&s->front, memory_order_acquire);
+		seq = atomic_load_explicit(&s->seq[f], memory_order_acquire);
+		if(seq & 1)
+			continue;
+
+		memcpy(cache, s->cache[f], sizeof(s->cache[f]));
+		gen = s->gen[f];
+
+		atomic_thread_fence(memory_order_acquire);
+		if(atomic_load_explicit(&s->seq[f], memory_order_relaxed) == seq)
+			return gen;
+	}
+}
+
+// one machine, paced to FPS on its own; inputs come from its replay
+
+void *tile_thread(void *arg)
+{
+	dash_tile *t = arg;
+
+	while(atomic_load_explicit(&running, memory_order_relaxed)) {
+		if(!pacer_due(&t->pacer)) {
+			pacer_wait(&t->pacer, NULL);
+			continue;
+		}
+		pacer_advance(&t->pacer);
+
+		while(t->next_event < t->event_count && t->events[t->next_event].cycle <= (uint32_t)t->cpu.totalticks) {
+			replay_apply(t->inputs, t->events[t->next_event].val);
+			t->next_event++;
+		}
+
+		ucom4_exec(&t->cpu, t->cpu.cpu_rate/FPS);
+		t->frames++;
+
+		if(memcmp(t->shown, t->cpu.display_cache, sizeof(t->shown))) {
+			memcpy(t->shown, t->cpu.display_cache, sizeof(t->shown));
+			snapshot_publish(&t->snap, t->shown);
+		}
+	}
+
+	return NULL;
+}
+
+// driver[:scale[:replay]]
+
+int tile_add(char *spec)
+{
+	dash_tile *t;
+	char *scale, *replay = NULL;
+
+	if(tile_count >= MAX_TILES) {
+		printf("At most %d tiles\n", MAX_TILES);
+		return -1;
+	}
+
+	t = &tiles[tile_count];
+	t->scale = DEFAULT_SCALE;
+
+	if((scale = strchr(spec, ':'))) {
+		*scale++ = 0;
+		if((replay = strchr(scale, ':')))
+			*replay++ = 0;
+		if(*scale)
+			t->scale = atof(scale);
+	}
+
+	if(!(t->game = driver_find(spec))) {
+		printf("Unknown driver %s\n", spec);
+		return -1;
+	}
+	if(t->scale <= 0) {
+		printf("Bad scale for tile %d\n", tile_count);
+		return -1;
+	}
+	if(replay && *replay && !(t->events = replay_load_stream(replay, &t->event_count))) {
+		printf("Cannot open replay file %s\n", replay);
+		return -1;
+	}
+
+	tile_count++;
+	return 0;
+}
+
+int tile_setup(dash_tile *t)
+{
+	if(load_rom(&t->cpu, t->game) != t->game->romsize) {
+		printf("Failed to load rom [%s]\n", t->game->rom);
+		return -1;
+	}
+	if(t->game->state_size && !(t->state = calloc(1, t->game->state_size)))
+		return -1;
+
+	machine_attach(&t->cpu, t->game, t->inputs, t->state);
+	ucom4_reset(&t->cpu);
+	t->cpu.cpu_rate = 100000;
+	t->cpu.sound_frequency = 0;         // no audio, nobody drains it
+
+	// the driver draws the snapshot, never the running cpu
+	machine_attach(&t->view, t->game, NULL, NULL);
+	t->drawn = ~0u;
+	t->render = render_create(t->game, &t->view);
+	if(!t->render) {
+		printf("Failed to load graphics for %s\n", t->game->name);
+		return -1;
+	}
+	t->render->out = SDL_CreateRGBSurface(SDL_SWSURFACE, t->render->w, t->render->h, 32, 0, 0, 0, 0);
+
+	return t->render->out ? 0 : -1;
+}
+
+// rows of cols tiles, each row as tall as its tallest tile
+
+void tile_layout(int *w, int *h)
+{
+	int x, tw, th, row_w = 0, row_h = 0;
+
+	*w = *h = 0;
+
+	for(x = 0; x < tile_count; x++) {
+		if(x && !(x % cols)) {
+			*h += row_h;
+			row_w = row_h = 0;
+		}
+
+		zoomSurfaceSize(tiles[x].render->w, tiles[x].render->h, tiles[x].scale, tiles[x].scale, &tw, &th);
+		tiles[x].rect.x = row_w;
+		tiles[x].rect.y = *h;
+		tiles[x].rect.w = tw;
+		tiles[x].rect.h = th;
+
+		row_w += tw;
+		if(th > row_h)
+			row_h = th;
+		if(row_w > *w)
+			*w = row_w;
+	}
+
+	*h += row_h;
+}
+
+// draw t into the window if its display moved on, or a segment image it
+// had to leave out has loaded since; 1 if it did
+
+int tile_draw(dash_tile *t)
+{
+	SDL_Surface *tmp;
+	SDL_Rect rect = t->rect;
+	unsigned loaded = atomic_load_explicit(&t->render->segs.decoded, memory_order_acquire);
+	uint32_t gen = snapshot_read(&t->snap, t->view.display_cache);
+
+	if(gen == t->drawn && loaded == t->loaded)
+		return 0;
+
+	t->drawn = gen;
+	t->loaded = loaded;
+	t->updates++;
+	render_update(t->render);
+
+	if(t->scale == 1.0) {
+		SDL_BlitSurface(t->render->out, NULL, screen, &rect);
+	} else {
+		tmp = zoomSurface(t->render->out, t->scale, t->scale, 1);
+		SDL_BlitSurface(tmp, NULL, screen, &rect);
+		SDL_FreeSurface(tmp);
+	}
+
+	return 1;
+}
+
+void tile_close(dash_tile *t)
+{
+	if(t->render) {
+		SDL_FreeSurface(t->render->out);
+		render_destroy(t->render);
+	}
+	free(t->state);
+	free(t->events);
+}
+
+void usage(void) {
+	fprintf(stderr, "usage: vfddash [-cols n] driver[:scale[:replay]] ...\n");
+	fprintf(stderr, "drivers:");
+	for(vfd_game **game = vfd_drivers; *game; game++)
+		fprintf(stderr, " %s", (*game)->name);
+	fprintf(stderr, "\n");
+}
+
+int main(int argc, char *argv[])
+{
+	SDL_Rect dirty[MAX_TILES];
+	SDL_Event event;
+	pacer frame_pacer;
+	int x, n, w, h;
+	int result = 0;
+
+	while(argc>1 && argv[1][0]=='-') {
+		if(!strcmp(argv[1],"-cols") && argc>2) {
+			cols = atoi(argv[2]);
+			argv++;
+			argc--;
+		} else {
+			usage();
+			return -1;
+		}
+		argv++;
+		argc--;
+	}
+
+	vfdlog_start();
+
+	if(argc < 2) {
+		usage();
+		return -1;
+	}
+
+	for(x = 1; x < argc; x++)
+		if(tile_add(argv[x]) < 0)
+			return -1;
+
+	if(cols < 1)
+		cols = (int)ceil(sqrt(tile_count));
+
+	SDL_Init(SDL_INIT_VIDEO);
+	atomic_init(&running, 1);
+
+	for(x = 0; x < tile_count; x++)
+		if(tile_setup(&tiles[x]) < 0) {
+			result = -1;
+			goto done;
+		}
+
+	tile_layout(&w, &h);
+	screen = SDL_SetVideoMode(w, h, 32, SDL_SWSURFACE);
+	if(!screen) {
+		printf("Cannot open a %dx%d window\n", w, h);
+		result = -1;
+		goto done;
+	}
+	SDL_WM_SetCaption("VFD dashboard", NULL);
+	SDL_FillRect(screen, NULL, SDL_MapRGB(screen->format, 0,0,0));
+	SDL_Flip(screen);
+
+	for(x = 0; x < tile_count; x++) {
+		pacer_init(&tiles[x].pacer, FPS);
+		if(pthread_create(&tiles[x].thread, NULL, tile_thread, &tiles[x])) {
+			printf("Cannot start tile %d\n", x);
+			result = -1;
+			goto done;
+		}
+		tiles[x].started = 1;
+	}
+
+	// the render thread: this one, SDL wants the window on the main thread
+	pacer_init(&frame_pacer, FPS);
+
+	while(atomic_load_explicit(&running, memory_order_relaxed)) {
+		while(SDL_PollEvent(&event)) {
+			if(event.type == SDL_QUIT || (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_ESCAPE))
+				atomic_store(&running, 0);
+		}
+
+		if(!pacer_due(&frame_pacer)) {
+			pacer_wait(&frame_pacer, NULL);
+			continue;
+		}
+		pacer_advance(&frame_pacer);
+
+		for(x = n = 0; x < tile_count; x++)
+			if(tile_draw(&tiles[x]))
+				dirty[n++] = tiles[x].rect;
+
+		if(n)
+			SDL_UpdateRects(screen, n, dirty);
+	}
+
+done:
+	atomic_store(&running, 0);
+	for(x = 0; x < tile_count; x++) {
+		if(tiles[x].started) {
+			pthread_join(tiles[x].thread, NULL);
+			printf("Tile %d %s: %u frames, %u drawn\n", x, tiles[x].game->name, tiles[x].frames, tiles[x].updates);
+		}
+		tile_close(&tiles[x]);
+	}
+	SDL_Quit();
+
+	return result;
+}
@@ -0,0 +1,59 @@
+/************************
+ *
+ * UCOM4 ROM ANALYSER
+ *
+ * (c) 2016 MikeDX
+ *
+ * vfddasm [-dot] <rom file>
+ *
+ *************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ucom4_cfg.h"
+
+int main(int argc, char *argv[])
+{
+	static ucom4_cfg cfg;
+	uint8_t rom[UCOM4_CFG_ROM];
+	char *file = NULL;
+	int dot = 0, x;
+	FILE *f;
+
+	for(x = 1; x < argc; x++) {
+		if(!strcmp(argv[x], "-dot"))
+			dot = 1;
+		else
+			file = argv[x];
+	}
+
+	if(!file) {
+		fprintf(stderr, "usage: vfddasm [-dot] <rom file>\n");
+		return -1;
+	}
+
+	f = fopen(file, "rb");
+	if(!f) {
+		fprintf(stderr, "Cannot open rom %s\n", file);
+		return -1;
+	}
+
+	memset(rom, 0, sizeof(rom));
+	if(fread(rom, 1, sizeof(rom), f) == 0) {
+		fprintf(stderr, "Empty rom %s\n", file);
+		fclose(f);
+		return -1;
+	}
+	fclose(f);
+
+	ucom4_cfg_analyse(&cfg, rom);
+
+	if(dot)
+		ucom4_cfg_dot(&cfg, rom, stdout);
+	else
+		ucom4_cfg_list(&cfg, rom, stdout);
+
+	return 0;
+}
@@ -0,0 +1,128 @@
+/************************
+ *
+ * SEGMENT LAYOUT COMPILER
+ *
+ * (c) 2016 MikeDX
+ *
+ * vfdlayout <layout.txt> <layout.lay>
+ *
+ * One segment per line: grid plate x y [image], image defaults to
+ * <grid>.<plate>.png. Segments are drawn in file order.
+ *
+ *************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "layout.h"
+
+#define MAX_SEGMENTS 1024
+
+static layout_seg segs[MAX_SEGMENTS];
+static char names[LAYOUT_ASSETS][LAYOUT_NAME];
+
+static void put16(FILE *f, int v)
+{
+	fputc(v & 0xff, f);
+	fputc((v >> 8) & 0xff, f);
+}
+
+static void put32(FILE *f, uint32_t v)
+{
+	put16(f, v & 0xffff);
+	put16(f, v >> 16);
+}
+
+int main(int argc, char *argv[])
+{
+	char line[256], image[256];
+	int count = 0, assets = 0, lineno = 0;
+	int grid, plate, x, y, n, a;
+	FILE *in, *out;
+
+	if(argc != 3) {
+		fprintf(stderr, "usage: vfdlayout <layout.txt> <layout.lay>\n");
+		return -1;
+	}
+
+	in = fopen(argv[1], "r");
+	if(!in) {
+		fprintf(stderr, "Cannot open %s\n", argv[1]);
+		return -1;
+	}
+
+	while(fgets(line, sizeof(line), in)) {
+		lineno++;
+		if(line[0] == '#' || line[0] == '\n')
+			continue;
+
+		n = sscanf(line, "%d %d %d %d %255s", &grid, &plate, &x, &y, image);
+		if(n < 4 || grid < 0 || grid > 255 || plate < 0 || plate > 255) {
+			fprintf(stderr, "%s:%d: expected grid plate x y [image]\n", argv[1], lineno);
+			return -1;
+		}
+		if(plate > 31) {
+			fprintf(stderr, "%s:%d: plate %d, a display row has 32\n", argv[1], lineno, plate);
+			return -1;
+		}
+		if(n == 4)
+			sprintf(image, "%d.%d.png", grid, plate);
+
+		if(strlen(image) >= LAYOUT_NAME) {
+			fprintf(stderr, "%s:%d: image name too long\n", argv[1], lineno);
+			return -1;
+		}
+
+		for(a = 0; a < assets && strcmp(names[a], image); a++)
+			;
+		if(a == assets) {
+			if(assets == LAYOUT_ASSETS) {
+				fprintf(stderr, "%s:%d: more than %d images\n", argv[1], lineno, LAYOUT_ASSETS);
+				return -1;
+			}
+			strcpy(names[assets++], image);
+		}
+
+		if(count == MAX_SEGMENTS) {
+			fprintf(stderr, "%s:%d: more than %d segments\n", argv[1], lineno, MAX_SEGMENTS);
+			return -1;
+		}
+		segs[count].grid = grid;
+		segs[count].plate = plate;
+		segs[count].x = x;
+		segs[count].y = y;
+		segs[count].asset = a;
+		count++;
+	}
+	fclose(in);
+
+	out = fopen(argv[2], "wb");
+	if(!out) {
+		fprintf(stderr, "Cannot write %s\n", argv[2]);
+		return -1;
+	}
+
+	put32(out, LAYOUT_MAGIC);
+	put16(out, LAYOUT_VERSION);
+	put16(out, count);
+	put16(out, assets);
+	put16(out, 0);
+	put16(out, 0);
+	put16(out, 0);
+
+	for(n = 0; n < count; n++) {
+		fputc(segs[n].grid, out);
+		fputc(segs[n].plate, out);
+		put16(out, segs[n].x);
+		put16(out, segs[n].y);
+		put16(out, segs[n].asset);
+	}
+
+	fwrite(names, LAYOUT_NAME, assets, out);
+	fclose(out);
+
+	printf("%s: %d segments, %d images\n", argv[2], count, assets);
+
+	return 0;
+}
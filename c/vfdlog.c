@@ -0,0 +1,305 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * vfdlog.c
+ *
+ *************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "vfdlog.h"
+
+#define VFDLOG_POLL_US 5000
+
+typedef struct _vfdlog_record {
+	const char *fmt;
+	uint8_t cat;
+	uint8_t lvl;
+	uint8_t count;
+	int64_t args[VFDLOG_ARGS];
+} vfdlog_record;
+
+// one producer (the owning thread), one consumer (the printer)
+typedef struct _vfdlog_ring {
+	atomic_uint head;
+	atomic_uint tail;
+	atomic_uint dropped;
+	struct _vfdlog_ring *next;
+	vfdlog_record records[VFDLOG_RING];
+} vfdlog_ring;
+
+static const char *category_names[LOG_CATEGORIES] = { "cpu", "driver", "nvram", "asp", "input", "frontend" };
+static const char *level_names[LOG_LEVELS] = { "error", "warn", "info", "debug" };
+
+// everything up to info is on by default
+uint32_t vfdlog_mask = 0x77777777 & ((1U << (LOG_CATEGORIES * LOG_LEVELS)) - 1);
+
+static __thread vfdlog_ring *own_ring;
+static vfdlog_ring *rings;
+static pthread_mutex_t rings_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t ring_key;          // frees a thread's ring when it exits
+static pthread_once_t ring_key_once = PTHREAD_ONCE_INIT;
+static pthread_t printer;
+static int started, quit;
+
+// one record, the argument types come from the conversions in the format
+
+static void vfdlog_format(FILE *f, vfdlog_record *r)
+{
+	const char *p = r->fmt, *start, *length;
+	char spec[32];
+	int arg = 0, len, wide;
+
+	while(*p) {
+		if(*p != '%') {
+			fputc(*p++, f);
+			continue;
+		}
+		if(p[1] == '%') {
+			fputc('%', f);
+			p += 2;
+			continue;
+		}
+
+		// flags, width and precision are kept, the length is ours
+		start = p++;
+		while(*p && strchr("-+ #0123456789.", *p))
+			p++;
+		len = p - start;
+		for(length = p; *p && strchr("hlzjt", *p); p++)
+			;
+		// without l, z, j or t the argument was an int
+		wide = p > length && *length != 'h';
+		if(!*p || len > (int)sizeof(spec) - 4)
+			break;
+
+		memcpy(spec, start, len);
+		if(arg >= r->count) {
+			fputs("?", f);
+		} else if(*p == 's' || *p == 'p') {
+			spec[len] = *p;
+			spec[len + 1] = 0;
+			if(*p == 's')
+				fprintf(f, spec, (const char *)(intptr_t)r->args[arg]);
+			else
+				fprintf(f, spec, (void *)(intptr_t)r->args[arg]);
+		} else if(*p == 'c') {
+			spec[len] = 'c';
+			spec[len + 1] = 0;
+			fprintf(f, spec, (int)r->args[arg]);
+		} else {
+			spec[len] = 'l';
+			spec[len + 1] = 'l';
+			spec[len + 2] = *p;
+			spec[len + 3] = 0;
+			if(*p == 'd' || *p == 'i')
+				fprintf(f, spec, wide ? (long long)r->args[arg] : (long long)(int32_t)r->args[arg]);
+			else
+				fprintf(f, spec, wide ? (unsigned long long)r->args[arg] : (unsigned long long)(uint32_t)r->args[arg]);
+		}
+		arg++;
+		p++;
+	}
+}
+
+// print what is in one ring, with rings_lock held
+
+static int vfdlog_drain_ring(vfdlog_ring *ring)
+{
+	unsigned head, tail, dropped;
+	int printed = 0;
+
+	head = atomic_load_explicit(&ring->head, memory_order_acquire);
+	tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+	for(; tail != head; tail++, printed++)
+		vfdlog_format(stdout, &ring->records[tail % VFDLOG_RING]);
+	atomic_store_explicit(&ring->tail, tail, memory_order_release);
+
+	if((dropped = atomic_exchange_explicit(&ring->dropped, 0, memory_order_relaxed)))
+		printf("[log] %u records dropped\n", dropped);
+
+	return printed;
+}
+
+static int vfdlog_drain(void)
+{
+	vfdlog_ring *ring;
+	int printed = 0;
+
+	pthread_mutex_lock(&rings_lock);
+	for(ring = rings; ring; ring = ring->next)
+		printed += vfdlog_drain_ring(ring);
+	pthread_mutex_unlock(&rings_lock);
+
+	if(printed)
+		fflush(stdout);
+
+	return printed;
+}
+
+static void *vfdlog_printer(void *data)
+{
+	(void)data;
+
+	while(!__atomic_load_n(&quit, __ATOMIC_ACQUIRE)) {
+		vfdlog_drain();
+		usleep(VFDLOG_POLL_US);
+	}
+
+	return NULL;
+}
+
+// the owning thread exits: print what it left, then drop its ring
+
+static void vfdlog_detach(void *data)
+{
+	vfdlog_ring *ring = data, **link;
+
+	pthread_mutex_lock(&rings_lock);
+	if(vfdlog_drain_ring(ring))
+		fflush(stdout);
+	for(link = &rings; *link; link = &(*link)->next) {
+		if(*link == ring) {
+			*link = ring->next;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&rings_lock);
+
+	free(ring);
+}
+
+static void vfdlog_make_key(void)
+{
+	pthread_key_create(&ring_key, vfdlog_detach);
+}
+
+static vfdlog_ring *vfdlog_attach(void)
+{
+	vfdlog_ring *ring = calloc(1, sizeof(vfdlog_ring));
+
+	if(!ring)
+		return NULL;
+
+	pthread_once(&ring_key_once, vfdlog_make_key);
+	pthread_setspecific(ring_key, ring);
+
+	pthread_mutex_lock(&rings_lock);
+	ring->next = rings;
+	rings = ring;
+	pthread_mutex_unlock(&rings_lock);
+
+	return ring;
+}
+
+// start the printer, from a frontend. Until then, and in the library,
+// records are not kept.
+
+void vfdlog_start(void)
+{
+	pthread_mutex_lock(&rings_lock);
+	if(!started && !quit) {
+		if(pthread_create(&printer, NULL, vfdlog_printer, NULL) == 0) {
+			__atomic_store_n(&started, 1, __ATOMIC_RELEASE);
+			atexit(vfdlog_close);
+		}
+	}
+	pthread_mutex_unlock(&rings_lock);
+}
+
+void vfdlog_put(int cat, int lvl, const char *fmt, const int64_t *args, int count)
+{
+	vfdlog_ring *ring = own_ring;
+	vfdlog_record *r;
+	unsigned head;
+	int x;
+
+	if(!ring && (!__atomic_load_n(&started, __ATOMIC_ACQUIRE) || !(ring = own_ring = vfdlog_attach())))
+		return;
+
+	head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+	if(head - atomic_load_explicit(&ring->tail, memory_order_acquire) >= VFDLOG_RING) {
+		atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+		return;
+	}
+
+	r = &ring->records[head % VFDLOG_RING];
+	r->fmt = fmt;
+	r->cat = cat;
+	r->lvl = lvl;
+	r->count = count < VFDLOG_ARGS ? count : VFDLOG_ARGS;
+	for(x = 0; x < r->count; x++)
+		r->args[x] = args[x];
+
+	atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+// "all=warn,nvram=debug,cpu=off": each category logs its level and
+// everything more severe. Nothing changes unless the whole spec is good.
+
+int vfdlog_config(const char *spec)
+{
+	char buf[256], *item, *save, *eq;
+	uint32_t mask = vfdlog_mask;
+	int cat, lvl, x, found;
+
+	snprintf(buf, sizeof(buf), "%s", spec);
+	for(item = strtok_r(buf, ",", &save); item; item = strtok_r(NULL, ",", &save)) {
+		if(!(eq = strchr(item, '=')))
+			return -1;
+		*eq++ = 0;
+
+		if(!strcmp(eq, "off"))
+			lvl = -1;
+		else {
+			for(lvl = 0; lvl < LOG_LEVELS && strcmp(eq, level_names[lvl]); lvl++)
+				;
+			if(lvl == LOG_LEVELS)
+				return -1;
+		}
+
+		for(cat = 0, found = 0; cat < LOG_CATEGORIES; cat++) {
+			if(strcmp(item, "all") && strcmp(item, category_names[cat]))
+				continue;
+			for(x = 0; x < LOG_LEVELS; x++) {
+				if(x <= lvl)
+					mask |= VFDLOG_BIT(cat, x);
+				else
+					mask &= ~VFDLOG_BIT(cat, x);
+			}
+			found = 1;
+		}
+		if(!found)
+			return -1;
+	}
+
+	vfdlog_mask = mask;
+
+	return 0;
+}
+
+// stop the printer and print whatever is left
+
+void vfdlog_close(void)
+{
+	pthread_mutex_lock(&rings_lock);
+	__atomic_store_n(&quit, 1, __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&rings_lock);
+
+	if(started) {
+		pthread_join(printer, NULL);
+		__atomic_store_n(&started, 0, __ATOMIC_RELEASE);
+	}
+
+	vfdlog_drain();
+}
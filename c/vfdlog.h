@@ -0,0 +1,71 @@
+/************************
+ *
+ * MULTI VFD EMULATOR
+ *
+ * (c) 2016 MikeDX
+ *
+ * http://github.com/MikeDX/astrowars
+ *
+ * vfdlog.h
+ *
+ *************************/
+
+#ifndef _VFDLOG_H_
+#define _VFDLOG_H_
+
+#include <stdint.h>
+
+// LOGGING
+//
+// vlog() checks one mask bit and, if it is set, drops a binary record
+// (format pointer plus up to VFDLOG_ARGS integer arguments) into the
+// calling thread's lock free ring. A background thread formats and
+// prints the records. A full ring drops records instead of waiting.
+// Only a frontend starts that thread (vfdlog_start); without it vlog()
+// keeps nothing.
+//
+// The format must be a string literal and %s arguments must point to
+// static strings, they are only looked at later.
+
+enum {
+	LOG_CPU = 0,
+	LOG_DRIVER,
+	LOG_NVRAM,
+	LOG_ASP,
+	LOG_INPUT,
+	LOG_FRONTEND,
+	LOG_CATEGORIES
+};
+
+enum {
+	LOG_ERROR = 0,
+	LOG_WARN,
+	LOG_INFO,
+	LOG_DEBUG,
+	LOG_LEVELS
+};
+
+#define VFDLOG_ARGS 4
+#define VFDLOG_RING 4096                // records per thread
+
+#define VFDLOG_BIT(cat, lvl) (1U << ((cat) * LOG_LEVELS + (lvl)))
+
+extern uint32_t vfdlog_mask;
+
+#define vlog(cat, lvl, fmt, ...)                                                \
+	do {                                                                        \
+		if(vfdlog_mask & VFDLOG_BIT(cat, lvl)) {                                \
+			const int64_t _vlog_args[] = { 0, ##__VA_ARGS__ };                  \
+			vfdlog_put((cat), (lvl), (fmt), _vlog_args + 1,                     \
+				sizeof(_vlog_args) / sizeof(_vlog_args[0]) - 1);                \
+		}                                                                       \
+	} while(0)
+
+#define VLOG_PTR(p) ((int64_t)(intptr_t)(p))
+
+void vfdlog_put(int cat, int lvl, const char *fmt, const int64_t *args, int count);
+int vfdlog_config(const char *spec);
+void vfdlog_start(void);
+void vfdlog_close(void);
+
+#endif